@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+// Read-only view of a contiguous array owned by someone else
+template <typename Type>
+class ArrayView {
+public:
+    ArrayView() = default;
+
+    ArrayView(const Type* data, size_t size)
+        : data_(data)
+        , size_(size) {
+    }
+
+    const Type* begin() const {
+        return data_;
+    }
+
+    const Type* end() const {
+        return data_ + size_;
+    }
+
+    const Type* data() const {
+        return data_;
+    }
+
+    const Type& operator[](size_t index) const {
+        return data_[index];
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+private:
+    const Type* data_ = nullptr;
+    size_t size_ = 0;
+};
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "compressed_postings.h"
+
+#include <cmath>
+
+namespace {
+
+const double MAX_QUANTISED_FREQ = 65535.0;
+
+void AppendVarint(std::vector<uint8_t>& bytes, uint32_t value) {
+    while (value >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarint(const uint8_t*& bytes) {
+    uint32_t value = 0;
+    int shift = 0;
+    while (*bytes & 0x80) {
+        value |= static_cast<uint32_t>(*bytes++ & 0x7f) << shift;
+        shift += 7;
+    }
+    value |= static_cast<uint32_t>(*bytes++) << shift;
+    return value;
+}
+
+} // namespace
+
+CompressedPostings::CompressedPostings(ArrayView<int> ids, ArrayView<double> freqs)
+    : size_(ids.size()) {
+    blocks_.reserve((size_ + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    freqs_.reserve(size_);
+
+    for (size_t block_begin = 0; block_begin < size_; block_begin += BLOCK_SIZE) {
+        const size_t block_end = std::min(size_, block_begin + BLOCK_SIZE);
+
+        const double max_freq = *std::max_element(freqs.begin() + block_begin, freqs.begin() + block_end);
+        const float freq_scale = static_cast<float>(max_freq / MAX_QUANTISED_FREQ);
+        blocks_.push_back({ids[block_begin], ids[block_end - 1], static_cast<uint32_t>(id_bytes_.size()), freq_scale});
+        // decoding multiplies by the scale, so no posting can come out above this
+        max_freq_ = std::max(max_freq_, MAX_QUANTISED_FREQ * static_cast<double>(freq_scale));
+
+        // the first id lives in the header, the rest are gaps to the previous one
+        for (size_t i = block_begin + 1; i < block_end; ++i) {
+            AppendVarint(id_bytes_, static_cast<uint32_t>(ids[i] - ids[i - 1]));
+        }
+        for (size_t i = block_begin; i < block_end; ++i) {
+            const double quantised = freq_scale > 0 ? std::round(freqs[i] / freq_scale) : 0.0;
+            freqs_.push_back(static_cast<uint16_t>(std::min(quantised, MAX_QUANTISED_FREQ)));
+        }
+    }
+    id_bytes_.shrink_to_fit();
+}
+
+void CompressedPostings::SetIds(const std::vector<int>& ids) {
+    std::vector<uint8_t> id_bytes;
+    id_bytes.reserve(id_bytes_.size());
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+        const size_t block_begin = block * BLOCK_SIZE;
+        const size_t block_end = std::min(size_, block_begin + BLOCK_SIZE);
+        BlockHeader& header = blocks_[block];
+        header.first_id = ids[block_begin];
+        header.last_id = ids[block_end - 1];
+        header.id_bytes_offset = static_cast<uint32_t>(id_bytes.size());
+        for (size_t i = block_begin + 1; i < block_end; ++i) {
+            AppendVarint(id_bytes, static_cast<uint32_t>(ids[i] - ids[i - 1]));
+        }
+    }
+    id_bytes.shrink_to_fit();
+    id_bytes_ = std::move(id_bytes);
+}
+
+bool CompressedPostings::Contains(int id) const {
+    const size_t block = FindBlock(id);
+    if (block == blocks_.size() || blocks_[block].first_id > id) {
+        return false;
+    }
+    int ids[BLOCK_SIZE];
+    double freqs[BLOCK_SIZE];
+    const size_t count = DecodeBlock(block, ids, freqs);
+    return std::binary_search(ids, ids + count, id);
+}
+
+size_t CompressedPostings::DecodeBlock(size_t block, int* ids, double* freqs) const {
+    const BlockHeader& header = blocks_[block];
+    const size_t block_begin = block * BLOCK_SIZE;
+    const size_t count = std::min(BLOCK_SIZE, size_ - block_begin);
+
+    const uint8_t* bytes = id_bytes_.data() + header.id_bytes_offset;
+    ids[0] = header.first_id;
+    for (size_t i = 1; i < count; ++i) {
+        ids[i] = ids[i - 1] + static_cast<int>(ReadVarint(bytes));
+    }
+    for (size_t i = 0; i < count; ++i) {
+        freqs[i] = freqs_[block_begin + i] * static_cast<double>(header.freq_scale);
+    }
+    return count;
+}
\ No newline at end of file
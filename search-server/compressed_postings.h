@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <climits>
+
+#include "array_view.h"
+
+// Read-only posting list packed into blocks of BLOCK_SIZE postings. Ids are
+// delta encoded as varints, term frequencies are quantised to 16 bits of the
+// block maximum: a decoded frequency is off by up to about max / 131070, where max
+// is the largest frequency of its block, so small frequencies next to a large one
+// have the largest relative error. Every block has a header with its id range, so
+// lookups and range scans skip blocks without decoding
+class CompressedPostings {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    CompressedPostings() = default;
+
+    // ids must be sorted ascending and non-negative
+    CompressedPostings(ArrayView<int> ids, ArrayView<double> freqs);
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    bool Contains(int id) const;
+
+    // Replaces every id with new_id(id), which must keep the order of the ids.
+    // Only the ids are encoded again, the quantised frequencies stay as they are
+    template <typename Function>
+    void RemapIds(Function new_id);
+
+    // Largest term frequency a decoded posting can have
+    double GetMaxFreq() const {
+        return max_freq_;
+    }
+
+    // Forward-only position in the list, decodes one block at a time
+    class Cursor {
+    public:
+        explicit Cursor(const CompressedPostings& postings)
+            : postings_(&postings) {
+            LoadBlock(0);
+        }
+
+        bool AtEnd() const {
+            return block_ >= postings_->blocks_.size();
+        }
+
+        int GetId() const {
+            return ids_[index_];
+        }
+
+        double GetFreq() const {
+            return freqs_[index_];
+        }
+
+        void Next() {
+            if (++index_ == count_) {
+                LoadBlock(block_ + 1);
+            }
+        }
+
+        // Moves to the first posting with id not below target
+        void SkipTo(int target) {
+            if (AtEnd() || ids_[index_] >= target) {
+                return;
+            }
+            if (postings_->blocks_[block_].last_id < target) {
+                LoadBlock(postings_->FindBlock(target, block_ + 1));
+                if (AtEnd()) {
+                    return;
+                }
+            }
+            while (ids_[index_] < target) {
+                ++index_;
+            }
+        }
+
+    private:
+        const CompressedPostings* postings_;
+        size_t block_ = 0;
+        size_t index_ = 0;
+        size_t count_ = 0;
+        int ids_[BLOCK_SIZE];
+        double freqs_[BLOCK_SIZE];
+
+        void LoadBlock(size_t block) {
+            block_ = block;
+            index_ = 0;
+            count_ = AtEnd() ? 0 : postings_->DecodeBlock(block, ids_, freqs_);
+        }
+    };
+
+    // function(id, freq) for every posting with range_begin <= id < range_end, in id order
+    template <typename Function>
+    void ForEach(int range_begin, int range_end, Function function) const {
+        int ids[BLOCK_SIZE];
+        double freqs[BLOCK_SIZE];
+        for (size_t block = FindBlock(range_begin); block < blocks_.size(); ++block) {
+            if (blocks_[block].first_id >= range_end) {
+                break;
+            }
+            const size_t count = DecodeBlock(block, ids, freqs);
+            for (size_t i = 0; i < count; ++i) {
+                if (ids[i] >= range_end) {
+                    break;
+                }
+                if (ids[i] >= range_begin) {
+                    function(ids[i], freqs[i]);
+                }
+            }
+        }
+    }
+
+    // Heap bytes held by the encoded postings
+    size_t GetMemoryUsage() const {
+        return blocks_.capacity() * sizeof(BlockHeader) + id_bytes_.capacity() + freqs_.capacity() * sizeof(uint16_t);
+    }
+
+private:
+    struct BlockHeader {
+        int first_id;
+        int last_id;
+        uint32_t id_bytes_offset;
+        float freq_scale; // max freq of the block divided by the largest quantised value
+    };
+
+    std::vector<BlockHeader> blocks_;
+    std::vector<uint8_t> id_bytes_;
+    std::vector<uint16_t> freqs_;
+    size_t size_ = 0;
+    double max_freq_ = 0.0;
+
+    // First block from first_block on whose last id is not below id, blocks_.size() if none
+    size_t FindBlock(int id, size_t first_block = 0) const {
+        return std::partition_point(blocks_.begin() + first_block, blocks_.end(), [id](const BlockHeader& header){
+            return header.last_id < id;
+        }) - blocks_.begin();
+    }
+
+    // Encodes ids, sorted ascending, in place of the current ones, of which there
+    // are as many; block boundaries and frequencies are kept
+    void SetIds(const std::vector<int>& ids);
+
+    // Writes the postings of the block and returns their number
+    size_t DecodeBlock(size_t block, int* ids, double* freqs) const;
+};
+
+template <typename Function>
+void CompressedPostings::RemapIds(Function new_id) {
+    std::vector<int> ids;
+    ids.reserve(size_);
+    ForEach(0, INT_MAX, [&](int id, double){
+        ids.push_back(new_id(id));
+    });
+    SetIds(ids);
+}
@@ -0,0 +1,21 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(SearchServer search_server)
+    : current_(std::make_shared<const SearchServer>(std::move(search_server))) {
+}
+
+std::shared_ptr<const SearchServer> ConcurrentSearchServer::GetSnapshot() const {
+    return std::atomic_load(&current_);
+}
+
+void ConcurrentSearchServer::AddDocuments(const DocumentBatch& batch) {
+    Update([&batch](SearchServer& search_server){
+        search_server.AddDocuments(std::execution::par, batch);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    Update([&document_ids](SearchServer& search_server){
+        search_server.RemoveDocuments(std::execution::par, document_ids);
+    });
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Serves queries while the index is being changed. Every change is applied to a
+// private copy of the current index version, which is then published with an
+// atomic pointer swap. Readers pin a version with GetSnapshot and query it with
+// no locks; a version is freed when the last reader holding it lets go.
+// Writers are serialised, and every Update copies the whole index once, so a
+// change costs as much as the index is big however small it is. That is why there
+// are no single-document calls: group many changes into one batch or one Update
+class ConcurrentSearchServer {
+public:
+    explicit ConcurrentSearchServer(SearchServer search_server);
+
+    // The current version; it never changes, however long it is held
+    std::shared_ptr<const SearchServer> GetSnapshot() const;
+
+    // Calls modify(SearchServer&) on a copy of the current version and publishes
+    // the result. If modify throws, nothing is published and the exception propagates
+    template <typename Function>
+    void Update(Function modify);
+
+    void AddDocuments(const DocumentBatch& batch);
+
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(const Args&... args) const {
+        return GetSnapshot()->FindTopDocuments(args...);
+    }
+
+    int GetDocumentCount() const {
+        return GetSnapshot()->GetDocumentCount();
+    }
+
+private:
+    std::shared_ptr<const SearchServer> current_; // read and replaced only with atomic_load/atomic_store
+    std::mutex update_mutex_;
+};
+
+template <typename Function>
+void ConcurrentSearchServer::Update(Function modify) {
+    std::lock_guard guard(update_mutex_);
+    auto next = std::make_shared<SearchServer>(*std::atomic_load(&current_));
+    modify(*next);
+    std::atomic_store(&current_, std::shared_ptr<const SearchServer>(std::move(next)));
+}
\ No newline at end of file
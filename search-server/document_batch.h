@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+// Documents collected for a single SearchServer::AddDocuments call. The batch
+// owns copies of the texts, so callers may drop theirs right after Add
+class DocumentBatch {
+public:
+    DocumentBatch& Add(int document_id, std::string_view document, DocumentStatus status,
+                       const std::vector<int>& ratings) {
+        documents_.push_back({document_id, std::string(document), status, ratings});
+        return *this;
+    }
+
+    void Reserve(size_t document_count) {
+        documents_.reserve(document_count);
+    }
+
+    size_t size() const {
+        return documents_.size();
+    }
+
+    bool empty() const {
+        return documents_.empty();
+    }
+
+    void Clear() {
+        documents_.clear();
+    }
+
+private:
+    friend class SearchServer;
+
+    struct Entry {
+        int id;
+        std::string text;
+        DocumentStatus status;
+        std::vector<int> ratings;
+    };
+
+    std::vector<Entry> documents_;
+};
\ No newline at end of file
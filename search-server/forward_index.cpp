@@ -0,0 +1,45 @@
+#include "forward_index.h"
+
+void ForwardIndex::Add(std::vector<std::pair<int, double>>& terms) {
+    std::sort(terms.begin(), terms.end());
+    ranges_.push_back({term_ids_.size(), terms.size()});
+    for (const auto& [term_id, term_freq] : terms) {
+        term_ids_.push_back(term_id);
+        term_freqs_.push_back(term_freq);
+    }
+}
+
+void ForwardIndex::Reset(const std::vector<size_t>& term_counts) {
+    ranges_.clear();
+    ranges_.reserve(term_counts.size());
+    size_t begin = 0;
+    for (size_t term_count : term_counts) {
+        ranges_.push_back({begin, 0});
+        begin += term_count;
+    }
+    term_ids_.assign(begin, 0);
+    term_freqs_.assign(begin, 0.0);
+}
+
+void ForwardIndex::Compact(const std::vector<size_t>& ordinals) {
+    std::vector<Range> ranges;
+    ranges.reserve(ordinals.size());
+    size_t term_count = 0;
+    for (size_t ordinal : ordinals) {
+        term_count += ranges_[ordinal].size;
+    }
+    std::vector<int> term_ids;
+    std::vector<double> term_freqs;
+    term_ids.reserve(term_count);
+    term_freqs.reserve(term_count);
+    for (size_t ordinal : ordinals) {
+        const Range& range = ranges_[ordinal];
+        ranges.push_back({term_ids.size(), range.size});
+        term_ids.insert(term_ids.end(), term_ids_.begin() + range.begin, term_ids_.begin() + range.begin + range.size);
+        term_freqs.insert(term_freqs.end(), term_freqs_.begin() + range.begin,
+                          term_freqs_.begin() + range.begin + range.size);
+    }
+    ranges_ = std::move(ranges);
+    term_ids_ = std::move(term_ids);
+    term_freqs_ = std::move(term_freqs);
+}
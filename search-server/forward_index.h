@@ -0,0 +1,164 @@
+#pragma once
+
+#include <vector>
+#include <string_view>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <cstddef>
+
+#include "array_view.h"
+#include "term_dictionary.h"
+
+// Terms of every document, addressed by ordinal: runs of term ids sorted ascending
+// with the matching frequencies, kept back to back in one pair of arrays.
+// A cleared document keeps its space, like its ordinal, until Compact
+class ForwardIndex {
+public:
+    // Appends the next ordinal; terms are (term id, frequency) pairs in any order
+    void Add(std::vector<std::pair<int, double>>& terms);
+
+    // Lays out term_counts.size() empty documents with room for term_counts[ordinal]
+    // terms each, for Append to fill
+    void Reset(const std::vector<size_t>& term_counts);
+
+    // Adds a term to a document laid out by Reset, in ascending term id order
+    void Append(size_t ordinal, int term_id, double term_freq) {
+        Range& range = ranges_[ordinal];
+        term_ids_[range.begin + range.size] = term_id;
+        term_freqs_[range.begin + range.size] = term_freq;
+        ++range.size;
+    }
+
+    // The document no longer has terms
+    void Clear(size_t ordinal) {
+        ranges_[ordinal].size = 0;
+    }
+
+    // Keeps only the documents at ordinals, ascending, which get ordinals 0, 1, ...
+    // in that order; the space of the others is given back
+    void Compact(const std::vector<size_t>& ordinals);
+
+    void Reserve(size_t ordinal_count, size_t term_count) {
+        ranges_.reserve(ordinal_count);
+        term_ids_.reserve(term_count);
+        term_freqs_.reserve(term_count);
+    }
+
+    ArrayView<int> GetTermIds(size_t ordinal) const {
+        const Range& range = ranges_[ordinal];
+        return {term_ids_.data() + range.begin, range.size};
+    }
+
+    ArrayView<double> GetTermFreqs(size_t ordinal) const {
+        const Range& range = ranges_[ordinal];
+        return {term_freqs_.data() + range.begin, range.size};
+    }
+
+    bool Contains(size_t ordinal, int term_id) const {
+        const ArrayView<int> term_ids = GetTermIds(ordinal);
+        return std::binary_search(term_ids.begin(), term_ids.end(), term_id);
+    }
+
+    // Ordinals laid out so far
+    size_t size() const {
+        return ranges_.size();
+    }
+
+private:
+    struct Range {
+        size_t begin;
+        size_t size;
+    };
+
+    std::vector<Range> ranges_;
+    std::vector<int> term_ids_;
+    std::vector<double> term_freqs_;
+};
+
+// Words of one document with their frequencies, in term id order. A view into the
+// index, valid until the index changes
+class WordFrequencies {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const TermDictionary* terms, const int* term_id, const double* term_freq)
+            : terms_(terms)
+            , term_id_(term_id)
+            , term_freq_(term_freq) {
+        }
+
+        value_type operator*() const {
+            return {terms_->GetTerm(*term_id_), *term_freq_};
+        }
+
+        Iterator& operator++() {
+            ++term_id_;
+            ++term_freq_;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const Iterator& other) const {
+            return term_id_ == other.term_id_;
+        }
+
+        bool operator!=(const Iterator& other) const {
+            return term_id_ != other.term_id_;
+        }
+
+    private:
+        const TermDictionary* terms_;
+        const int* term_id_;
+        const double* term_freq_;
+    };
+
+    WordFrequencies() = default;
+
+    WordFrequencies(const TermDictionary* terms, ArrayView<int> term_ids, ArrayView<double> term_freqs)
+        : terms_(terms)
+        , term_ids_(term_ids)
+        , term_freqs_(term_freqs) {
+    }
+
+    Iterator begin() const {
+        return {terms_, term_ids_.begin(), term_freqs_.begin()};
+    }
+
+    Iterator end() const {
+        return {terms_, term_ids_.end(), term_freqs_.end()};
+    }
+
+    size_t size() const {
+        return term_ids_.size();
+    }
+
+    bool empty() const {
+        return term_ids_.empty();
+    }
+
+    // Ids of the words in the term dictionary of the index, sorted ascending
+    ArrayView<int> GetTermIds() const {
+        return term_ids_;
+    }
+
+    ArrayView<double> GetTermFreqs() const {
+        return term_freqs_;
+    }
+
+private:
+    const TermDictionary* terms_ = nullptr;
+    ArrayView<int> term_ids_;
+    ArrayView<double> term_freqs_;
+};
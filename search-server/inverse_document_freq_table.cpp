@@ -0,0 +1,50 @@
+#include "inverse_document_freq_table.h"
+
+#include <cstdlib>
+
+InverseDocumentFreqTable::InverseDocumentFreqTable(const InverseDocumentFreqTable& other) {
+    *this = other;
+}
+
+InverseDocumentFreqTable& InverseDocumentFreqTable::operator=(const InverseDocumentFreqTable& other) {
+    if (this == &other) {
+        return *this;
+    }
+    std::lock_guard guard(other.refresh_mutex_);
+    max_drift_ = other.max_drift_;
+    document_count_ = other.document_count_;
+    values_document_count_ = other.values_document_count_;
+    values_ = other.values_;
+    is_marked_ = other.is_marked_;
+    marked_terms_ = other.marked_terms_;
+    is_all_stale_ = other.is_all_stale_;
+    is_count_stale_ = other.is_count_stale_;
+    is_stale_.store(other.is_stale_.load());
+    return *this;
+}
+
+void InverseDocumentFreqTable::SetMaxDrift(double max_drift) {
+    max_drift_ = max_drift;
+    SetDocumentCount(document_count_);
+}
+
+void InverseDocumentFreqTable::MarkTerm(int term_id) {
+    if (is_marked_.size() <= static_cast<size_t>(term_id)) {
+        is_marked_.resize(term_id + 1, false);
+    }
+    if (!is_marked_[term_id]) {
+        is_marked_[term_id] = true;
+        marked_terms_.push_back(term_id);
+    }
+    is_stale_ = true;
+}
+
+void InverseDocumentFreqTable::SetDocumentCount(size_t document_count) {
+    document_count_ = document_count;
+    const double drift = std::abs(static_cast<double>(document_count) - static_cast<double>(values_document_count_));
+    // the values are brought up to date one by one as queries read them
+    if (drift > max_drift_ * values_document_count_) {
+        is_count_stale_ = true;
+        is_stale_ = true;
+    }
+}
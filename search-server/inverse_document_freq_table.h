@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+
+// log(N / n) for every term id, where N is the number of documents and n the
+// number of documents with the term. Writers report what changed; the terms whose
+// n changed are recomputed on the next Refresh. A change of N touches every term,
+// so each value remembers the N it was computed for and is recomputed when a query
+// reads it after N moved; only Invalidate makes Refresh sweep every term.
+// With a max drift above zero N is only taken up once it moves further than
+// max_drift * N from the value the table was computed for, which keeps hot terms
+// cached across small changes. The default drift of 0 keeps every value exact
+class InverseDocumentFreqTable {
+public:
+    InverseDocumentFreqTable() = default;
+
+    // Copies the values; safe while readers refresh other
+    InverseDocumentFreqTable(const InverseDocumentFreqTable& other);
+    InverseDocumentFreqTable& operator=(const InverseDocumentFreqTable& other);
+
+    void SetMaxDrift(double max_drift);
+
+    double GetMaxDrift() const {
+        return max_drift_;
+    }
+
+    // The number of documents with term_id changed
+    void MarkTerm(int term_id);
+
+    // The number of documents is now document_count
+    void SetDocumentCount(size_t document_count);
+
+    // Every value is recomputed with the current document count on the next Refresh
+    void Invalidate() {
+        is_all_stale_ = true;
+        is_stale_ = true;
+    }
+
+    // Brings the marked values up to date; document_freq(term_id) is the current
+    // number of documents with the term, ids go up to term_limit.
+    // Safe to call from many readers at once, but not together with the writer calls
+    template <typename DocumentFreq>
+    void Refresh(size_t term_limit, DocumentFreq document_freq) const;
+
+    // Valid after Refresh; a value left from an older N is recomputed with
+    // document_freq and kept. Safe to call from many readers at once
+    template <typename DocumentFreq>
+    double Get(int term_id, DocumentFreq document_freq) const;
+
+private:
+    static constexpr size_t NOT_COMPUTED = static_cast<size_t>(-1);
+
+    // Readers may recompute the same value at once; they store equal numbers, and
+    // the document count is stored last, so a reader seeing it sees the value too
+    struct Value {
+        std::atomic<double> value = 0.0;
+        std::atomic<size_t> document_count = NOT_COMPUTED; // the N value is computed for
+
+        Value() = default;
+
+        Value(const Value& other)
+            : value(other.value.load(std::memory_order_relaxed))
+            , document_count(other.document_count.load(std::memory_order_relaxed)) {
+        }
+
+        Value& operator=(const Value& other) {
+            value.store(other.value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            document_count.store(other.document_count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+
+        void Store(double new_value, size_t new_document_count) {
+            value.store(new_value, std::memory_order_relaxed);
+            document_count.store(new_document_count, std::memory_order_release);
+        }
+    };
+
+    double max_drift_ = 0.0;
+    size_t document_count_ = 0;           // the current one
+    mutable size_t values_document_count_ = 0; // the one the values are computed for
+
+    mutable std::vector<Value> values_;
+    mutable std::vector<char> is_marked_;
+    mutable std::vector<int> marked_terms_;
+    mutable bool is_all_stale_ = false;
+    mutable bool is_count_stale_ = false; // values_document_count_ is to become document_count_
+
+    mutable std::atomic<bool> is_stale_ = false;
+    mutable std::mutex refresh_mutex_;
+
+    static double Compute(size_t document_count, size_t term_document_freq) {
+        // released terms are never looked up
+        return term_document_freq == 0 ? 0.0 : std::log(document_count * 1.0 / term_document_freq);
+    }
+};
+
+template <typename DocumentFreq>
+void InverseDocumentFreqTable::Refresh(size_t term_limit, DocumentFreq document_freq) const {
+    if (!is_stale_.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard guard(refresh_mutex_);
+    if (!is_stale_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    if (is_all_stale_ || is_count_stale_) {
+        values_document_count_ = document_count_;
+    }
+    const auto compute = [&](size_t term_id){
+        values_[term_id].Store(Compute(values_document_count_, document_freq(static_cast<int>(term_id))),
+                               values_document_count_);
+    };
+
+    values_.resize(term_limit);
+    if (is_all_stale_) {
+        for (size_t term_id = 0; term_id < term_limit; ++term_id) {
+            compute(term_id);
+        }
+    } else {
+        for (int term_id : marked_terms_) {
+            compute(term_id);
+        }
+    }
+    for (int term_id : marked_terms_) {
+        is_marked_[term_id] = false;
+    }
+    marked_terms_.clear();
+    is_all_stale_ = false;
+    is_count_stale_ = false;
+
+    is_stale_.store(false, std::memory_order_release);
+}
+
+template <typename DocumentFreq>
+double InverseDocumentFreqTable::Get(int term_id, DocumentFreq document_freq) const {
+    Value& value = values_[term_id];
+    if (value.document_count.load(std::memory_order_acquire) == values_document_count_) {
+        return value.value.load(std::memory_order_relaxed);
+    }
+    const double result = Compute(values_document_count_, document_freq(term_id));
+    value.Store(result, values_document_count_);
+    return result;
+}
@@ -76,5 +76,27 @@ int main() {
             PrintDocument(document);
         }
     }
+
+    // запрос длиной ровно в MIN_PARALLEL_MATCH_WORDS слов: с этой длины
+    // параллельная версия MatchDocument не должна проигрывать последовательной
+    string long_query;
+    for (size_t i = 0; i < SearchServer::MIN_PARALLEL_MATCH_WORDS; ++i) {
+        long_query += "word"s + to_string(i) + (i % 4 == 0 ? " cat "s : " "s);
+    }
+    const int match_count = 2000;
+    size_t matched_words = 0;
+    {
+        LOG_DURATION("MATCH SEQUENCE AT CUTOFF");
+        for (int i = 1; i <= match_count; ++i) {
+            matched_words += get<0>(search_server.MatchDocument(execution::seq, long_query, i)).size();
+        }
+    }
+    {
+        LOG_DURATION("MATCH PARALLEL AT CUTOFF");
+        for (int i = 1; i <= match_count; ++i) {
+            matched_words += get<0>(search_server.MatchDocument(execution::par, long_query, i)).size();
+        }
+    }
+    cout << "Matched words: "s << matched_words << endl;
     return 0;
 }
\ No newline at end of file
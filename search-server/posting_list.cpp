@@ -0,0 +1,119 @@
+#include "posting_list.h"
+
+#include <algorithm>
+#include <iterator>
+#include <climits>
+
+PostingList PostingList::Borrow(const int* ids, const double* freqs, std::size_t size) {
+    PostingList postings;
+    if (size > 0) {
+        postings.borrowed_ids_ = ids;
+        postings.borrowed_freqs_ = freqs;
+        postings.borrowed_size_ = size;
+        postings.max_freq_ = *std::max_element(freqs, freqs + size);
+    }
+    return postings;
+}
+
+PostingList::Cursor::Cursor(const PostingList& postings) {
+    if (postings.IsCompressed()) {
+        compressed_.emplace(postings.compressed_);
+        return;
+    }
+    const ArrayView<int> ids = postings.GetPlainIds();
+    ids_ = ids.begin();
+    ids_end_ = ids.end();
+    freqs_ = postings.GetPlainFreqs().begin();
+}
+
+void PostingList::Cursor::SkipForward(int target) {
+    if (compressed_) {
+        compressed_->SkipTo(target);
+        return;
+    }
+    // targets are usually close, so gallop before the binary search
+    const int* low = ids_;
+    size_t step = 1;
+    while (low + step < ids_end_ && low[step] < target) {
+        low += step;
+        step *= 2;
+    }
+    const int* next = std::lower_bound(low, std::min(low + step + 1, ids_end_), target);
+    freqs_ += next - ids_;
+    ids_ = next;
+}
+
+void PostingList::Own() {
+    if (IsCompressed()) {
+        ids_.reserve(compressed_.size());
+        freqs_.reserve(compressed_.size());
+        compressed_.ForEach(0, INT_MAX, [this](int document_id, double term_freq){
+            ids_.push_back(document_id);
+            freqs_.push_back(term_freq);
+        });
+        compressed_ = CompressedPostings();
+        return;
+    }
+    if (borrowed_ids_ == nullptr) {
+        return;
+    }
+    ids_.assign(borrowed_ids_, borrowed_ids_ + borrowed_size_);
+    freqs_.assign(borrowed_freqs_, borrowed_freqs_ + borrowed_size_);
+    borrowed_ids_ = nullptr;
+    borrowed_freqs_ = nullptr;
+    borrowed_size_ = 0;
+}
+
+void PostingList::Compress() {
+    if (IsCompressed() || size() < CompressedPostings::BLOCK_SIZE) {
+        return;
+    }
+    compressed_ = CompressedPostings(GetPlainIds(), GetPlainFreqs());
+    max_freq_ = compressed_.GetMaxFreq();
+    ids_ = std::vector<int>();
+    freqs_ = std::vector<double>();
+    borrowed_ids_ = nullptr;
+    borrowed_freqs_ = nullptr;
+    borrowed_size_ = 0;
+}
+
+void PostingList::Add(int document_id, double term_freq) {
+    Own();
+    // ids usually grow, so the common case is a plain append
+    if (ids_.empty() || ids_.back() < document_id) {
+        ids_.push_back(document_id);
+        freqs_.push_back(term_freq);
+        max_freq_ = std::max(max_freq_, term_freq);
+        return;
+    }
+
+    auto it = std::lower_bound(ids_.begin(), ids_.end(), document_id);
+    const auto index = std::distance(ids_.begin(), it);
+    if (it != ids_.end() && *it == document_id) {
+        freqs_[index] += term_freq;
+        max_freq_ = std::max(max_freq_, freqs_[index]);
+        return;
+    }
+    max_freq_ = std::max(max_freq_, term_freq);
+    ids_.insert(it, document_id);
+    freqs_.insert(freqs_.begin() + index, term_freq);
+}
+
+bool PostingList::Contains(int document_id) const {
+    if (IsCompressed()) {
+        return compressed_.Contains(document_id);
+    }
+    const ArrayView<int> ids = GetPlainIds();
+    return std::binary_search(ids.begin(), ids.end(), document_id);
+}
+
+void PostingList::Erase(int document_id) {
+    Own();
+    auto it = std::lower_bound(ids_.begin(), ids_.end(), document_id);
+    if (it == ids_.end() || *it != document_id) {
+        return;
+    }
+    const auto index = std::distance(ids_.begin(), it);
+    ids_.erase(it);
+    freqs_.erase(freqs_.begin() + index);
+}
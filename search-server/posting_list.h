@@ -0,0 +1,174 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+#include <memory>
+#include <optional>
+
+#include "array_view.h"
+#include "compressed_postings.h"
+
+// Postings of a single term: document ids sorted ascending and the matching
+// term frequencies. They are kept in one of three forms:
+//  - two owned parallel arrays, the only form that is changed in place;
+//  - arrays borrowed from external memory such as a mapped snapshot;
+//  - CompressedPostings blocks after Compress().
+// The last two are turned back into owned arrays on the first change
+class PostingList {
+public:
+    PostingList() = default;
+
+    // ids and freqs must outlive the list and every copy of it
+    static PostingList Borrow(const int* ids, const double* freqs, std::size_t size);
+
+    void Add(int document_id, double term_freq);
+
+    bool Contains(int document_id) const;
+
+    void Erase(int document_id);
+
+    // Drops every posting with is_removed(document_id) in one pass
+    template <typename Predicate>
+    void EraseIf(Predicate is_removed);
+
+    // Replaces every document id with new_id(document_id); new_id must keep the
+    // order of the ids. A compressed list stays compressed, with its frequencies as
+    // they were quantised
+    template <typename Function>
+    void RemapIds(Function new_id);
+
+    // Switches to the compressed form; lists shorter than one block are left as they are
+    void Compress();
+
+    bool IsCompressed() const {
+        return !compressed_.empty();
+    }
+
+    // function(document_id, term_freq) for every posting with range_begin <= id < range_end, in id order
+    template <typename Function>
+    void ForEach(int range_begin, int range_end, Function function) const {
+        if (IsCompressed()) {
+            compressed_.ForEach(range_begin, range_end, function);
+            return;
+        }
+        const ArrayView<int> ids = GetPlainIds();
+        const ArrayView<double> freqs = GetPlainFreqs();
+        const int* ids_end = std::lower_bound(ids.begin(), ids.end(), range_end);
+        for (const int* it = std::lower_bound(ids.begin(), ids_end, range_begin); it != ids_end; ++it) {
+            function(*it, freqs[it - ids.begin()]);
+        }
+    }
+
+    // Upper bound of the term frequencies in the list. Erase does not lower it
+    double GetMaxFreq() const {
+        return max_freq_;
+    }
+
+    // Forward-only position in the list, for document-at-a-time evaluation
+    class Cursor {
+    public:
+        explicit Cursor(const PostingList& postings);
+
+        bool AtEnd() const {
+            return compressed_ ? compressed_->AtEnd() : ids_ == ids_end_;
+        }
+
+        int GetId() const {
+            return compressed_ ? compressed_->GetId() : *ids_;
+        }
+
+        double GetFreq() const {
+            return compressed_ ? compressed_->GetFreq() : *freqs_;
+        }
+
+        void Next() {
+            if (compressed_) {
+                compressed_->Next();
+            } else {
+                ++ids_;
+                ++freqs_;
+            }
+        }
+
+        // Moves to the first posting with id not below target
+        void SkipTo(int target) {
+            if (!compressed_ && (ids_ == ids_end_ || *ids_ >= target)) {
+                return;
+            }
+            SkipForward(target);
+        }
+
+    private:
+        const int* ids_ = nullptr;
+        const int* ids_end_ = nullptr;
+        const double* freqs_ = nullptr;
+        // inline, so opening a cursor never allocates
+        std::optional<CompressedPostings::Cursor> compressed_;
+
+        void SkipForward(int target);
+    };
+
+    std::size_t size() const {
+        if (IsCompressed()) {
+            return compressed_.size();
+        }
+        return borrowed_ids_ ? borrowed_size_ : ids_.size();
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    std::vector<int> ids_;
+    std::vector<double> freqs_;
+
+    const int* borrowed_ids_ = nullptr;
+    const double* borrowed_freqs_ = nullptr;
+    std::size_t borrowed_size_ = 0;
+
+    CompressedPostings compressed_;
+
+    double max_freq_ = 0.0;
+
+    ArrayView<int> GetPlainIds() const {
+        return borrowed_ids_ ? ArrayView<int>(borrowed_ids_, borrowed_size_)
+                             : ArrayView<int>(ids_.data(), ids_.size());
+    }
+
+    ArrayView<double> GetPlainFreqs() const {
+        return borrowed_ids_ ? ArrayView<double>(borrowed_freqs_, borrowed_size_)
+                             : ArrayView<double>(freqs_.data(), freqs_.size());
+    }
+
+    // Turns borrowed or compressed postings into owned arrays before a change
+    void Own();
+};
+
+template <typename Predicate>
+void PostingList::EraseIf(Predicate is_removed) {
+    Own();
+    size_t kept = 0;
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        if (!is_removed(ids_[i])) {
+            ids_[kept] = ids_[i];
+            freqs_[kept] = freqs_[i];
+            ++kept;
+        }
+    }
+    ids_.resize(kept);
+    freqs_.resize(kept);
+}
+
+template <typename Function>
+void PostingList::RemapIds(Function new_id) {
+    if (IsCompressed()) {
+        compressed_.RemapIds(new_id);
+        return;
+    }
+    Own();
+    for (int& id : ids_) {
+        id = new_id(id);
+    }
+}
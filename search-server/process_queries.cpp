@@ -3,19 +3,33 @@
 #include <algorithm>
 #include <execution>
 
+namespace {
+
+ThreadPool& GetDefaultPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace
+
 
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries){
 
-    std::vector<std::vector<Document>> result(queries.size());
+    return ProcessQueries(search_server, queries, GetDefaultPool());
+}
 
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    ThreadPool& pool){
 
-    std::transform(std::execution::par, queries.begin(), queries.end(),result.begin(),
-    [&search_server](const std::string& quer){
-        return search_server.FindTopDocuments(quer);
-    }
-    );
+    std::vector<std::vector<Document>> result(queries.size());
+
+    ProcessQueriesStreamed(search_server, queries, pool, [&result](size_t i, const std::vector<Document>& documents){
+        result[i] = documents;
+    });
 
     return result;
 }
@@ -24,18 +38,30 @@ std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries){
 
-    auto temp = ProcessQueries(search_server, queries);
-    std::vector<Document> result;
-    result.reserve(temp.size() * MAX_RESULT_DOCUMENT_COUNT);
-
+    return ProcessQueriesJoined(search_server, queries, GetDefaultPool());
+}
 
-    for(const auto& vectors : temp){
-        result.insert(result.end(), vectors.begin(), vectors.end());
+std::vector<Document> ProcessQueriesJoined(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    ThreadPool& pool){
+
+    // every query gets room for a full top, the gaps are closed afterwards
+    std::vector<Document> result(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+    std::vector<size_t> counts(queries.size());
+
+    ProcessQueriesStreamed(search_server, queries, pool, [&](size_t i, const std::vector<Document>& documents){
+        std::copy(documents.begin(), documents.end(), result.begin() + i * MAX_RESULT_DOCUMENT_COUNT);
+        counts[i] = documents.size();
+    });
+
+    size_t size = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const auto first = result.begin() + i * MAX_RESULT_DOCUMENT_COUNT;
+        std::move(first, first + counts[i], result.begin() + size);
+        size += counts[i];
     }
+    result.resize(size);
 
     return result;
-
 }
-
-
-
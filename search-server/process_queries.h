@@ -1,16 +1,77 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <atomic>
+#include <mutex>
 #include "document.h"
 #include "search_server.h"
+#include "thread_pool.h"
 #include <list>
 
 
+// Runs the batch on a pool shared by every call without one
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
+// Every worker of pool runs a loop taking the next query when done with its last
+// one. While all of them are busy a query runs whole with MaxScore; once some are
+// idle, e.g. near the end of the batch, a heavy query is split into tasks of the
+// pool for them to steal
+std::vector<std::vector<Document>> ProcessQueries(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    ThreadPool& pool);
+
+
+// The answers of all queries back to back, in query order, written straight into
+// one buffer without a vector per query
+std::vector<Document> ProcessQueriesJoined(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries);
 
 std::vector<Document> ProcessQueriesJoined(
     const SearchServer& search_server,
-    const std::vector<std::string>& queries); 
\ No newline at end of file
+    const std::vector<std::string>& queries,
+    ThreadPool& pool);
+
+
+// Calls function(query_index, documents) for every query as soon as it is answered,
+// in completion order and one call at a time; documents is valid during the call
+// only. Each worker takes the next query when done with its last one and reuses its
+// buffers, so memory does not grow with the batch. A loop never returns to the pool
+// between queries, so a query is only split when there are idle workers to take
+// its pieces
+template <typename Function>
+void ProcessQueriesStreamed(
+    const SearchServer& search_server,
+    const std::vector<std::string>& queries,
+    ThreadPool& pool,
+    Function function){
+
+    std::atomic<size_t> next_query = 0;
+    std::mutex function_mutex;
+
+    ThreadPool::TaskGroup group;
+    const size_t task_count = std::min(queries.size(), pool.GetThreadCount());
+    for (size_t task = 0; task < task_count; ++task) {
+        pool.Run(group, [&]{
+            SearchServer::QueryContext context;
+            try {
+                for (size_t i = next_query++; i < queries.size(); i = next_query++) {
+                    // pieces nobody is free to steal would only cost MaxScore its pruning
+                    const std::vector<Document>& documents = pool.GetIdleThreadCount() > 0
+                        ? search_server.FindTopDocuments(context, PoolPolicy(pool), queries[i])
+                        : search_server.FindTopDocuments(context, std::execution::seq, queries[i]);
+                    std::lock_guard guard(function_mutex);
+                    function(i, documents);
+                }
+            } catch (...) {
+                // the other workers stop at their next query
+                next_query = queries.size();
+                throw;
+            }
+        });
+    }
+    pool.Wait(group);
+}
@@ -0,0 +1,53 @@
+#include "query_cache.h"
+
+std::optional<std::vector<Document>> QueryCache::Find(const std::string& key, uint64_t generation) {
+    SetGeneration(generation);
+    const auto it = key_to_entry_.find(key);
+    if (it == key_to_entry_.end()) {
+        return std::nullopt;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->documents;
+}
+
+void QueryCache::Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents) {
+    SetGeneration(generation);
+    const auto it = key_to_entry_.find(key);
+    if (it != key_to_entry_.end()) {
+        memory_usage_ -= GetEntrySize(*it->second);
+        it->second->documents = documents;
+        memory_usage_ += GetEntrySize(*it->second);
+        entries_.splice(entries_.begin(), entries_, it->second);
+    } else {
+        entries_.push_front({key, documents});
+        // the map key views the string owned by the list node, which never moves
+        key_to_entry_.emplace(entries_.front().key, entries_.begin());
+        memory_usage_ += GetEntrySize(entries_.front());
+    }
+
+    while (memory_usage_ > max_memory_usage_ && !entries_.empty()) {
+        const Entry& oldest = entries_.back();
+        memory_usage_ -= GetEntrySize(oldest);
+        key_to_entry_.erase(oldest.key);
+        entries_.pop_back();
+    }
+}
+
+void QueryCache::Clear() {
+    key_to_entry_.clear();
+    entries_.clear();
+    memory_usage_ = 0;
+}
+
+void QueryCache::SetGeneration(uint64_t generation) {
+    if (generation != generation_) {
+        Clear();
+        generation_ = generation;
+    }
+}
+
+size_t QueryCache::GetEntrySize(const Entry& entry) {
+    // list node, hash node and both heap buffers; the node overheads are estimates
+    const size_t node_overhead = 64;
+    return sizeof(Entry) + node_overhead + entry.key.capacity() + entry.documents.capacity() * sizeof(Document);
+}
\ No newline at end of file
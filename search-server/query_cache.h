@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+#include "document.h"
+
+// Search results by query key, all computed for one index generation. Seeing
+// another generation drops everything; past the memory limit the least
+// recently used results are evicted
+class QueryCache {
+public:
+    explicit QueryCache(size_t max_memory_usage)
+        : max_memory_usage_(max_memory_usage) {
+    }
+
+    std::optional<std::vector<Document>> Find(const std::string& key, uint64_t generation);
+
+    void Insert(const std::string& key, uint64_t generation, const std::vector<Document>& documents);
+
+    void Clear();
+
+    size_t size() const {
+        return entries_.size();
+    }
+
+    // Approximate bytes held by the cached results
+    size_t GetMemoryUsage() const {
+        return memory_usage_;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::vector<Document> documents;
+    };
+
+    size_t max_memory_usage_;
+    size_t memory_usage_ = 0;
+    uint64_t generation_ = 0;
+    std::list<Entry> entries_; // most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> key_to_entry_;
+
+    void SetGeneration(uint64_t generation);
+
+    static size_t GetEntrySize(const Entry& entry);
+};
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// Relevance of the documents whose ordinals fall in [range_begin, range_end),
+// kept in dense arrays indexed by ordinal. Not synchronised: every worker of a
+// query owns its own accumulator over its own range
+class RelevanceAccumulator {
+public:
+    RelevanceAccumulator() = default;
+
+    RelevanceAccumulator(size_t range_begin, size_t range_end)
+        : range_begin_(range_begin)
+        , range_size_(range_end - range_begin)
+        , relevances_(range_size_, 0.0)
+        , is_matched_(range_size_, false) {
+    }
+
+    // Same as a fresh accumulator over the new range, but keeps the memory
+    void Reset(size_t range_begin, size_t range_end) {
+        const size_t range_size = range_end - range_begin;
+        if (range_size == range_size_) {
+            // only matched slots were written to
+            for (const size_t ordinal : matched_) {
+                relevances_[ordinal - range_begin_] = 0.0;
+                is_matched_[ordinal - range_begin_] = false;
+            }
+            std::fill(excluded_.begin(), excluded_.end(), 0);
+        } else {
+            relevances_.assign(range_size, 0.0);
+            is_matched_.assign(range_size, false);
+            excluded_.clear();
+        }
+        matched_.clear();
+        range_begin_ = range_begin;
+        range_size_ = range_size;
+    }
+
+    // Marks a document that must never be matched; excluded documents are
+    // tracked in a bitset allocated on the first call
+    void Exclude(size_t ordinal) {
+        if (excluded_.empty()) {
+            excluded_.assign((range_size_ + 63) / 64, 0);
+        }
+        const size_t index = ordinal - range_begin_;
+        excluded_[index / 64] |= uint64_t(1) << (index % 64);
+    }
+
+    bool IsExcluded(size_t ordinal) const {
+        if (excluded_.empty()) {
+            return false;
+        }
+        const size_t index = ordinal - range_begin_;
+        return (excluded_[index / 64] >> (index % 64)) & 1;
+    }
+
+    // The document must not be excluded
+    void Add(size_t ordinal, double relevance) {
+        const size_t index = ordinal - range_begin_;
+        if (!is_matched_[index]) {
+            is_matched_[index] = true;
+            matched_.push_back(ordinal);
+        }
+        relevances_[index] += relevance;
+    }
+
+    size_t size() const {
+        return matched_.size();
+    }
+
+    // Makes ForEach go in ordinal order
+    void SortMatched() {
+        // when many documents matched, one pass over the flags beats sorting
+        if (matched_.size() * 16 < range_size_) {
+            std::sort(matched_.begin(), matched_.end());
+            return;
+        }
+        matched_.clear();
+        for (size_t index = 0; index < range_size_; ++index) {
+            if (is_matched_[index]) {
+                matched_.push_back(range_begin_ + index);
+            }
+        }
+    }
+
+    // function(ordinal, relevance) for every matched document, in first-match order
+    // or in ordinal order after SortMatched
+    template <typename Function>
+    void ForEach(Function function) const {
+        for (const size_t ordinal : matched_) {
+            function(ordinal, relevances_[ordinal - range_begin_]);
+        }
+    }
+
+private:
+    size_t range_begin_ = 0;
+    size_t range_size_ = 0;
+    std::vector<double> relevances_;
+    std::vector<char> is_matched_;
+    std::vector<uint64_t> excluded_;
+    // ordinals in the order they were first matched, so ForEach skips untouched slots
+    std::vector<size_t> matched_;
+};
\ No newline at end of file
@@ -1,38 +1,167 @@
 #include "remove_duplicates.h"
 
-void RemoveDuplicates(SearchServer& search_server){
+#include <array>
+#include <unordered_map>
 
-    using namespace std;
+namespace {
 
-    std::vector<std::vector<string_view>> words_id; // size - N
+const size_t MIN_HASH_COUNT = 64;
+// bands of rows: two documents become candidates when a whole band matches
+const size_t LSH_ROWS = 4;
+const size_t LSH_BANDS = MIN_HASH_COUNT / LSH_ROWS;
 
-    vector<int>  documents_id_to_delete;
+using MinHashSignature = std::array<uint64_t, MIN_HASH_COUNT>;
 
-    for(const int document_id : search_server){         // O(N)
-        std::map<std::string_view, double> word_to_freq = search_server.GetWordFrequencies(document_id); // O(logN)   
-        std::vector<string_view> words_; 
-        for(const auto& [word, freq] : word_to_freq){
-            words_.push_back(word);
+uint64_t HashWord(std::string_view word) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    for (char c : word) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// splitmix64 finaliser, spreads close inputs apart
+uint64_t Mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// Term ids come sorted, so equal sets give equal hashes
+uint64_t HashWordSet(const WordFrequencies& word_freqs) {
+    uint64_t hash = word_freqs.size();
+    for (int term_id : word_freqs.GetTermIds()) {
+        hash = Mix(hash ^ static_cast<uint64_t>(term_id));
+    }
+    return hash;
+}
+
+bool HaveSameWords(const WordFrequencies& lhs, const WordFrequencies& rhs) {
+    const ArrayView<int> lhs_term_ids = lhs.GetTermIds();
+    const ArrayView<int> rhs_term_ids = rhs.GetTermIds();
+    return lhs_term_ids.size() == rhs_term_ids.size()
+           && std::equal(lhs_term_ids.begin(), lhs_term_ids.end(), rhs_term_ids.begin());
+}
+
+MinHashSignature ComputeMinHash(const WordFrequencies& word_freqs) {
+    MinHashSignature signature;
+    signature.fill(UINT64_MAX);
+    for (const auto& [word, freq] : word_freqs) {
+        const uint64_t word_hash = HashWord(word);
+        for (size_t i = 0; i < MIN_HASH_COUNT; ++i) {
+            signature[i] = std::min(signature[i], Mix(word_hash + i * 0x9e3779b97f4a7c15ull));
         }
+    }
+    return signature;
+}
+
+double EstimateSimilarity(const MinHashSignature& lhs, const MinHashSignature& rhs) {
+    size_t equal_count = 0;
+    for (size_t i = 0; i < MIN_HASH_COUNT; ++i) {
+        equal_count += lhs[i] == rhs[i];
+    }
+    return static_cast<double>(equal_count) / MIN_HASH_COUNT;
+}
 
-        bool match = false;
-        
-        for(const auto& words : words_id){
-            if(words == words_){
-                match = true;
-                std::cout << "Found duplicate document id " << document_id << endl;
-                break;
+std::vector<int> GetDocumentIds(SearchServer& search_server) {
+    return std::vector<int>(search_server.begin(), search_server.end());
+}
+
+template <typename ExecutionPolicy>
+std::vector<int> RemoveDuplicatesImpl(ExecutionPolicy policy, SearchServer& search_server) {
+    const std::vector<int> document_ids = GetDocumentIds(search_server);
+    std::vector<uint64_t> hashes(document_ids.size());
+    std::transform(policy, document_ids.begin(), document_ids.end(), hashes.begin(), [&search_server](int document_id){
+        return HashWordSet(search_server.GetWordFrequencies(document_id));
+    });
+
+    // ids go in ascending order, so the first document of every group is kept
+    std::unordered_map<uint64_t, std::vector<int>> hash_to_kept_ids;
+    hash_to_kept_ids.reserve(document_ids.size());
+    std::vector<int> removed_ids;
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const WordFrequencies word_freqs = search_server.GetWordFrequencies(document_ids[i]);
+        auto& kept_ids = hash_to_kept_ids[hashes[i]];
+        // a hash collision must not remove a distinct document
+        const bool is_duplicate = std::any_of(kept_ids.begin(), kept_ids.end(), [&](int kept_id){
+            return HaveSameWords(search_server.GetWordFrequencies(kept_id), word_freqs);
+        });
+        if (is_duplicate) {
+            removed_ids.push_back(document_ids[i]);
+        } else {
+            kept_ids.push_back(document_ids[i]);
+        }
+    }
+
+    search_server.RemoveDocuments(policy, removed_ids);
+    return removed_ids;
+}
+
+template <typename ExecutionPolicy>
+std::vector<int> RemoveNearDuplicatesImpl(ExecutionPolicy policy, SearchServer& search_server, double min_similarity) {
+    const std::vector<int> document_ids = GetDocumentIds(search_server);
+    std::vector<MinHashSignature> signatures(document_ids.size());
+    std::transform(policy, document_ids.begin(), document_ids.end(), signatures.begin(), [&search_server](int document_id){
+        return ComputeMinHash(search_server.GetWordFrequencies(document_id));
+    });
+
+    // band hash to indexes of kept documents with that band, one table per band
+    std::vector<std::unordered_map<uint64_t, std::vector<size_t>>> bands(LSH_BANDS);
+    std::vector<int> removed_ids;
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        const MinHashSignature& signature = signatures[i];
+        std::array<uint64_t, LSH_BANDS> band_hashes;
+        bool is_duplicate = false;
+        for (size_t band = 0; band < LSH_BANDS && !is_duplicate; ++band) {
+            uint64_t band_hash = band;
+            for (size_t row = 0; row < LSH_ROWS; ++row) {
+                band_hash = Mix(band_hash ^ signature[band * LSH_ROWS + row]);
+            }
+            band_hashes[band] = band_hash;
+            const auto it = bands[band].find(band_hash);
+            if (it != bands[band].end()) {
+                is_duplicate = std::any_of(it->second.begin(), it->second.end(), [&](size_t kept){
+                    return EstimateSimilarity(signatures[kept], signature) >= min_similarity;
+                });
             }
         }
-        if(match == true){
-            documents_id_to_delete.push_back(document_id);
+        if (is_duplicate) {
+            removed_ids.push_back(document_ids[i]);
+            continue;
+        }
+        for (size_t band = 0; band < LSH_BANDS; ++band) {
+            bands[band][band_hashes[band]].push_back(i);
         }
-        if(match == false) words_id.push_back(words_);
     }
 
-    for(int id : documents_id_to_delete){
-        search_server.RemoveDocument(id);
-        //cout << "удален айди " << id << endl;
-    }
+    search_server.RemoveDocuments(policy, removed_ids);
+    return removed_ids;
+}
+
+} // namespace
+
+std::vector<int> RemoveDuplicates(std::execution::sequenced_policy policy, SearchServer& search_server) {
+    return RemoveDuplicatesImpl(policy, search_server);
 }
-    
\ No newline at end of file
+
+std::vector<int> RemoveDuplicates(std::execution::parallel_policy policy, SearchServer& search_server) {
+    return RemoveDuplicatesImpl(policy, search_server);
+}
+
+std::vector<int> RemoveDuplicates(SearchServer& search_server) {
+    return RemoveDuplicates(std::execution::seq, search_server);
+}
+
+std::vector<int> RemoveNearDuplicates(std::execution::sequenced_policy policy, SearchServer& search_server,
+                                      double min_similarity) {
+    return RemoveNearDuplicatesImpl(policy, search_server, min_similarity);
+}
+
+std::vector<int> RemoveNearDuplicates(std::execution::parallel_policy policy, SearchServer& search_server,
+                                      double min_similarity) {
+    return RemoveNearDuplicatesImpl(policy, search_server, min_similarity);
+}
+
+std::vector<int> RemoveNearDuplicates(SearchServer& search_server, double min_similarity) {
+    return RemoveNearDuplicates(std::execution::seq, search_server, min_similarity);
+}
\ No newline at end of file
@@ -1,4 +1,19 @@
 #pragma once
 #include "search_server.h"
 
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+// Removes every document whose set of words equals that of a document with a
+// smaller id. Documents are hashed into word-set signatures and grouped in a
+// hash table, so the cost is linear. Returns the removed ids in ascending order
+std::vector<int> RemoveDuplicates(std::execution::sequenced_policy policy, SearchServer& search_server);
+std::vector<int> RemoveDuplicates(std::execution::parallel_policy policy, SearchServer& search_server);
+std::vector<int> RemoveDuplicates(SearchServer& search_server);
+
+// Also removes near duplicates: documents whose word sets have an estimated
+// Jaccard similarity of at least min_similarity with a kept document of smaller id.
+// MinHash signatures are bucketed by LSH bands, so only likely pairs are compared;
+// pairs below about 0.5 similarity are almost never found
+std::vector<int> RemoveNearDuplicates(std::execution::sequenced_policy policy, SearchServer& search_server,
+                                      double min_similarity);
+std::vector<int> RemoveNearDuplicates(std::execution::parallel_policy policy, SearchServer& search_server,
+                                      double min_similarity);
+std::vector<int> RemoveNearDuplicates(SearchServer& search_server, double min_similarity);
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "request_queue.h"
 
 std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, DocumentStatus status) {
-    std::vector<Document> temp = server_.FindTopDocuments(raw_query, status);
+    std::vector<Document> temp = FindCached(raw_query, status);
     QueryResult temp_query;
     temp_query.count_documents = temp.size();
     AddQueryResult(temp_query);
@@ -9,13 +9,25 @@ std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query, D
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(std::string_view raw_query) {
-    std::vector<Document> temp = server_.FindTopDocuments(raw_query);
+    std::vector<Document> temp = FindCached(raw_query, DocumentStatus::ACTUAL);
     QueryResult temp_query;
     temp_query.count_documents = temp.size();
     AddQueryResult(temp_query);
     return temp;
 }
 
+std::vector<Document> RequestQueue::FindCached(std::string_view raw_query, DocumentStatus status) {
+    std::string key = server_.NormalizeQuery(raw_query);
+    key.push_back(static_cast<char>('0' + static_cast<int>(status)));
+    const uint64_t generation = server_.GetGeneration();
+    if (auto cached = cache_.Find(key, generation)) {
+        return std::move(*cached);
+    }
+    std::vector<Document> result = server_.FindTopDocuments(raw_query, status);
+    cache_.Insert(key, generation, result);
+    return result;
+}
+
 void RequestQueue::AddQueryResult(const QueryResult& query){
     if(requests_.size() >= min_in_day_){
         QueryResult results = requests_.front();
@@ -4,10 +4,15 @@
 #include <string>
 #include <deque>
 #include "search_server.h"
+#include "query_cache.h"
 
 class RequestQueue {
 public:
-    explicit RequestQueue(const SearchServer& search_server):server_(search_server) {}
+    static const size_t DEFAULT_CACHE_MEMORY = 16 * 1024 * 1024;
+
+    // Results of status queries are cached up to cache_memory bytes; 0 turns the cache off
+    explicit RequestQueue(const SearchServer& search_server, size_t cache_memory = DEFAULT_CACHE_MEMORY)
+        : server_(search_server), cache_(cache_memory) {}
     // сделаем "обёртки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
     template <typename DocumentPredicate>
     std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate);
@@ -25,11 +30,15 @@ private:
     };
 
     void AddQueryResult(const QueryResult& query);
+
+    std::vector<Document> FindCached(std::string_view raw_query, DocumentStatus status);
     
     std::deque<QueryResult> requests_;
     const static int min_in_day_ = 1440;
     const SearchServer& server_;
     int count_ = 0;
+    // predicates cannot be compared, so only status queries go through the cache
+    QueryCache cache_;
 };
 
 template <typename DocumentPredicate>
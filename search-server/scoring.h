@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+using namespace std::literals;
+
+// Scoring models rank documents for SearchServer::FindTopDocumentsScored. A model is
+// any type with
+//     Scorer Prepare(const CorpusStats& stats) const;
+// called once per query, where Scorer has
+//     double Score(double term_freq, double inverse_document_freq, int document_length) const;
+//     double GetMaxScore(double max_term_freq, double inverse_document_freq) const;
+// Score gives the part of a document's relevance one query word adds, where
+// term_freq is the share of the document's words equal to it and document_length
+// the number of its words without stop words. Score must not decrease with
+// term_freq, and GetMaxScore must not be below Score for any document with at
+// most max_term_freq, or the sequential search may drop documents from the top.
+// The scorer is a template argument of the posting loops, so Score is inlined there
+
+// Index statistics a model may use, fixed for one query
+struct CorpusStats {
+    double average_document_length = 0.0;
+};
+
+// term_freq * inverse_document_freq, the default ranking
+class TfIdfScoring {
+public:
+    TfIdfScoring Prepare(const CorpusStats&) const {
+        return *this;
+    }
+
+    double Score(double term_freq, double inverse_document_freq, int) const {
+        return term_freq * inverse_document_freq;
+    }
+
+    double GetMaxScore(double max_term_freq, double inverse_document_freq) const {
+        return max_term_freq * inverse_document_freq;
+    }
+};
+
+// Okapi BM25 over the index's inverse document frequencies: repeated words saturate
+// at k1 and long documents are damped by b
+class Bm25Scoring {
+public:
+    static constexpr double DEFAULT_K1 = 1.2;
+    static constexpr double DEFAULT_B = 0.75;
+
+    explicit Bm25Scoring(double k1 = DEFAULT_K1, double b = DEFAULT_B)
+        : k1_(k1)
+        , b_(b) {
+        if (!(k1 >= 0.0) || !(b >= 0.0 && b <= 1.0)) {
+            throw std::invalid_argument("BM25 needs k1 >= 0 and b in [0, 1]"s);
+        }
+    }
+
+    Bm25Scoring Prepare(const CorpusStats& stats) const {
+        Bm25Scoring result = *this;
+        result.base_norm_ = k1_ * (1.0 - b_);
+        result.length_norm_ = stats.average_document_length > 0.0
+                             ? k1_ * b_ / stats.average_document_length : 0.0;
+        return result;
+    }
+
+    double Score(double term_freq, double inverse_document_freq, int document_length) const {
+        const double word_count = term_freq * document_length;
+        return inverse_document_freq * word_count * (k1_ + 1.0)
+               / (word_count + base_norm_ + length_norm_ * document_length);
+    }
+
+    // word_count / (word_count + norm) stays below 1
+    double GetMaxScore(double, double inverse_document_freq) const {
+        return inverse_document_freq * (k1_ + 1.0);
+    }
+
+    double GetK1() const {
+        return k1_;
+    }
+
+    double GetB() const {
+        return b_;
+    }
+
+private:
+    double k1_;
+    double b_;
+    // per query
+    double base_norm_ = 0.0;
+    double length_norm_ = 0.0;
+};
@@ -1,31 +1,232 @@
 #include "search_server.h"
 
 #include<iterator>
+#include <unordered_set>
+#include <fstream>
+#include <cstring>
+#include <climits>
+#include <cstdio>
+#include <atomic>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'S', 'R', 'C', 'H', 'I', 'D', 'X', '\0'};
+// 2 added document lengths
+const uint32_t SNAPSHOT_VERSION = 2;
+// written in native byte order, a snapshot from a different architecture is rejected
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t stop_word_count;
+    uint64_t stop_word_bytes;
+    uint64_t document_count;
+    uint64_t term_count;
+    uint64_t term_bytes;
+    uint64_t posting_count;
+};
+
+struct SnapshotDocument {
+    int32_t id;
+    int32_t rating;
+    int32_t status;
+    int32_t length;
+};
+
+struct SnapshotTerm {
+    uint64_t text_offset;
+    uint64_t text_length;
+    uint64_t posting_offset;
+    uint64_t posting_count;
+};
+
+// Every section starts at a multiple of 8 bytes, so mapped arrays are aligned
+const size_t SNAPSHOT_ALIGNMENT = 8;
+
+// Writes next to the target and renames over it at the end: a server mapping the
+// old file keeps its inode, and a failed save leaves the old snapshot in place
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path)
+        : path_(path)
+        , temp_path_(path + ".tmp"s)
+        , out_(temp_path_, std::ios::binary | std::ios::trunc) {
+        if (!out_) {
+            throw std::runtime_error("Can not create "s + temp_path_);
+        }
+    }
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    ~SnapshotWriter() {
+        if (!is_finished_) {
+            out_.close();
+            std::remove(temp_path_.c_str());
+        }
+    }
+
+    template <typename Type>
+    void WriteArray(const Type* data, size_t count) {
+        out_.write(reinterpret_cast<const char*>(data), count * sizeof(Type));
+        position_ += count * sizeof(Type);
+        const char padding[SNAPSHOT_ALIGNMENT] = {};
+        const size_t padding_size = (SNAPSHOT_ALIGNMENT - position_ % SNAPSHOT_ALIGNMENT) % SNAPSHOT_ALIGNMENT;
+        out_.write(padding, padding_size);
+        position_ += padding_size;
+    }
+
+    void Finish() {
+        out_.close();
+        if (!out_) {
+            throw std::runtime_error("Can not write snapshot"s);
+        }
+        if (std::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+            throw std::runtime_error("Can not replace "s + path_);
+        }
+        is_finished_ = true;
+    }
+
+private:
+    std::string path_;
+    std::string temp_path_;
+    std::ofstream out_;
+    size_t position_ = 0;
+    bool is_finished_ = false;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size)
+        : data_(data)
+        , size_(size) {
+    }
+
+    template <typename Type>
+    const Type* ReadArray(uint64_t count) {
+        if (count > (size_ - position_) / sizeof(Type)) {
+            throw std::runtime_error("Snapshot is truncated"s);
+        }
+        const Type* result = reinterpret_cast<const Type*>(data_ + position_);
+        position_ += count * sizeof(Type);
+        position_ = std::min(size_, (position_ + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT);
+        return result;
+    }
+
+    bool AtEnd() const {
+        return position_ == size_;
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t position_ = 0;
+};
+
+} // namespace
 
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
                  const std::vector<int>& ratings) {
-    if ((document_id < 0) || (documents_.count(document_id) > 0)) {
+    if ((document_id < 0) || (id_to_ordinal_.count(document_id) > 0)) {
         throw std::invalid_argument("Invalid document_id"s);
     }
 
-    //std::string documents_s(document);
-    const auto words = SplitIntoWordsNoStop(document);
+    // reused by every document of the thread, so indexing does not allocate for them
+    thread_local DocumentTerms terms;
+    ComputeTermFreqs(document, terms);
+    IndexDocument(document_id, status, ComputeAverageRating(ratings), terms);
+}
+
+void SearchServer::AddDocuments(const DocumentBatch& batch) {
+    AddDocuments(std::execution::seq, batch);
+}
+
+void SearchServer::CheckBatchIds(const DocumentBatch& batch) const {
+    std::unordered_set<int> batch_ids;
+    batch_ids.reserve(batch.size());
+    for (const auto& entry : batch.documents_) {
+        if ((entry.id < 0) || (id_to_ordinal_.count(entry.id) > 0) || !batch_ids.insert(entry.id).second) {
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+    }
+}
 
+void SearchServer::ComputeTermFreqs(std::string_view document, DocumentTerms& result) const {
+    thread_local std::vector<std::string_view> words;
+    SplitIntoWordsNoStop(document, words);
     const double inv_word_count = 1.0 / words.size();
+    std::sort(words.begin(), words.end());
+
+    // repeated addition, not count * inv_word_count, to keep the exact frequencies
+    result.length = static_cast<int>(words.size());
+    auto& term_freqs = result.term_freqs;
+    term_freqs.clear();
     for (std::string_view word : words) {
+        if (term_freqs.empty() || term_freqs.back().first != word) {
+            term_freqs.emplace_back(word, 0.0);
+        }
+        term_freqs.back().second += inv_word_count;
+    }
+}
 
-        dictionary_.emplace_back(std::move(std::string(word)));
+void SearchServer::IndexDocument(int document_id, DocumentStatus status, int rating, const DocumentTerms& terms) {
+    const size_t ordinal = documents_.size();
+    generation_ = NextGeneration();
 
-        word_to_document_freqs_[dictionary_.back()][document_id] += inv_word_count;
-        word_to_freqs_[document_id][dictionary_.back()] += inv_word_count;
+    thread_local std::vector<std::pair<int, double>> forward_terms;
+    forward_terms.clear();
+    for (const auto& [word, term_freq] : terms.term_freqs) {
+        const int term_id = terms_.Intern(word);
+        if (postings_.size() <= static_cast<size_t>(term_id)) {
+            postings_.resize(terms_.GetIdLimit());
+        }
+        // one posting per distinct word, appended once its frequency is final
+        postings_[term_id].Add(ordinal, term_freq);
+        inverse_document_freqs_.MarkTerm(term_id);
+        forward_terms.emplace_back(term_id, term_freq);
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    forward_index_.Add(forward_terms);
+    documents_.push_back(DocumentData{document_id, rating, status, terms.length});
+    total_document_length_ += terms.length;
+    id_to_ordinal_.emplace(document_id, ordinal);
     document_ids_.insert(document_id);
+    inverse_document_freqs_.SetDocumentCount(id_to_ordinal_.size());
 }
 
 
+uint64_t SearchServer::NextGeneration() {
+    static std::atomic<uint64_t> next_generation = 0;
+    return next_generation++;
+}
+
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return id_to_ordinal_.size();
+}
+
+double SearchServer::GetAverageDocumentLength() const {
+    return id_to_ordinal_.empty() ? 0.0 : static_cast<double>(total_document_length_) / id_to_ordinal_.size();
+}
+
+size_t SearchServer::GetDocumentFreq(std::string_view word) const {
+    const int term_id = terms_.Find(word);
+    return term_id == TermDictionary::NO_TERM ? 0 : postings_[term_id].size();
+}
+
+std::string SearchServer::NormalizeQuery(std::string_view raw_query) const {
+    const Query query = ParseQuery(raw_query);
+    std::string key;
+    for (std::string_view word : query.plus_words) {
+        key.append(word);
+        key.push_back(' ');
+    }
+    for (std::string_view word : query.minus_words) {
+        key.push_back('-');
+        key.append(word);
+        key.push_back(' ');
+    }
+    return key;
 }
 
 std::set<int>::iterator SearchServer::begin(){
@@ -36,38 +237,36 @@ std::set<int>::iterator SearchServer::end(){
     return document_ids_.end();
 }
 
- const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    if(word_to_freqs_.count(document_id) == 0){
-        static std::map<std::string_view, double> temp;
-        return  temp;
+ WordFrequencies SearchServer::GetWordFrequencies(int document_id) const {
+    const auto ordinal_it = id_to_ordinal_.find(document_id);
+    if(ordinal_it == id_to_ordinal_.end()){
+        return {};
     }
 
-    return word_to_freqs_.at(document_id); // O(log N)
+    const size_t ordinal = ordinal_it->second;
+    return {&terms_, forward_index_.GetTermIds(ordinal), forward_index_.GetTermFreqs(ordinal)};
  }
 
 
 bool SearchServer::IsStopWord(std::string_view word) const {
-    return stop_words_.count(std::string(word)) > 0;
+    return stop_words_.Contains(word);
 }
 
 
-std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const {
-    std::vector<std::string_view> words;
-    //std::string_view copy(text);
-    for (std::string_view word : SplitIntoWordsView(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("Word "s + std::string(word) + " is invalid"s);
-        }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
-        }
+void SearchServer::SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const {
+    // the tokenizer checks for control characters in the same pass
+    const size_t invalid_word = SplitIntoWordsView(text, words);
+    if (invalid_word < words.size()) {
+        throw std::invalid_argument("Word "s + std::string(words[invalid_word]) + " is invalid"s);
     }
-    return words;
+    words.erase(std::remove_if(words.begin(), words.end(), [this](std::string_view word){
+        return IsStopWord(word);
+    }), words.end());
 }
 
 
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const {
+SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text, bool is_valid) const {
     if (text.empty()) {
         throw std::invalid_argument("Query word is empty"s);
     }
@@ -77,7 +276,7 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
         is_minus = true;
         word = word.substr(1);
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)) {
+    if (word.empty() || word[0] == '-' || !is_valid) {
         throw std::invalid_argument("Query word "s + std::string(text) + " is invalid");
     }
 
@@ -87,11 +286,26 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) cons
 
 
 SearchServer::Query SearchServer::ParseQuerySimple(std::string_view text) const {
+    // reused by every query of the thread
+    thread_local std::vector<std::string_view> words;
     Query result;
+    ParseQuerySimple(text, words, result);
+    return result;
+}
 
-    for (std::string_view word : SplitIntoWordsView(text)) {
+SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
+    thread_local std::vector<std::string_view> words;
+    Query result;
+    ParseQuery(text, words, result);
+    return result;
+}
 
-        const auto query_word = ParseQueryWord(word);
+void SearchServer::ParseQuerySimple(std::string_view text, std::vector<std::string_view>& words, Query& result) const {
+    result.plus_words.clear();
+    result.minus_words.clear();
+    const size_t invalid_word = SplitIntoWordsView(text, words);
+    for (size_t i = 0; i < words.size(); ++i) {
+        const auto query_word = ParseQueryWord(words[i], i != invalid_word);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 result.minus_words.push_back(query_word.data);
@@ -100,11 +314,10 @@ SearchServer::Query SearchServer::ParseQuerySimple(std::string_view text) const
             }
         }
     }
-    return result;
 }
 
-SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
-    Query result = ParseQuerySimple(text);
+void SearchServer::ParseQuery(std::string_view text, std::vector<std::string_view>& words, Query& result) const {
+    ParseQuerySimple(text, words, result);
 
     std::sort(result.minus_words.begin(), result.minus_words.end());
     auto last_m = std::unique(result.minus_words.begin(), result.minus_words.end());
@@ -113,13 +326,38 @@ SearchServer::Query SearchServer::ParseQuery(std::string_view text) const {
     std::sort(result.plus_words.begin(), result.plus_words.end());
     auto last_p = std::unique(result.plus_words.begin(), result.plus_words.end());
     result.plus_words.erase(last_p, result.plus_words.end());
-    return result;
 }
 
 
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+void SearchServer::PrepareInverseDocumentFreqs() const {
+    inverse_document_freqs_.Refresh(postings_.size(), [this](int term_id){
+        return postings_[term_id].size();
+    });
+}
+
+void SearchServer::SetInverseDocumentFreqMaxDrift(double max_drift) {
+    generation_ = NextGeneration();
+    inverse_document_freqs_.SetMaxDrift(max_drift);
+}
+
+void SearchServer::RefreshInverseDocumentFreqs() {
+    generation_ = NextGeneration();
+    inverse_document_freqs_.Invalidate();
+    PrepareInverseDocumentFreqs();
+}
+
+void SearchServer::FindTermIds(const std::vector<std::string_view>& words, std::vector<int>& term_ids) const {
+    term_ids.clear();
+    term_ids.reserve(words.size());
+    for (std::string_view word : words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != TermDictionary::NO_TERM) {
+            term_ids.push_back(term_id);
+        }
+    }
+    std::sort(term_ids.begin(), term_ids.end());
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
 }
 
 bool SearchServer::IsValidWord(std::string_view word){
@@ -128,6 +366,23 @@ bool SearchServer::IsValidWord(std::string_view word){
     });
 }
 
+size_t SearchServer::GetWorkerCount(size_t posting_count, size_t max_worker_count) {
+    // below this many postings per worker the thread start-up costs more than the scan
+    const size_t min_postings_per_worker = 4096;
+    return std::clamp<size_t>(posting_count / min_postings_per_worker, 1, std::max<size_t>(max_worker_count, 1));
+}
+
+size_t SearchServer::CountPlusPostings(const Query& query) const {
+    size_t posting_count = 0;
+    for (std::string_view word : query.plus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != TermDictionary::NO_TERM) {
+            posting_count += postings_[term_id].size();
+        }
+    }
+    return posting_count;
+}
+
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
     if (ratings.empty()) {
         return 0;
@@ -141,52 +396,202 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> 
 SearchServer::MatchDocument(std::execution::parallel_policy policy, std::string_view raw_query, int document_id) const {
-    
-    auto query = ParseQuerySimple(raw_query);
-    std::vector<std::string_view> matched_words(query.plus_words.size());
+    const size_t ordinal = id_to_ordinal_.at(document_id);
+    const Query query = ParseQuerySimple(raw_query);
+    if (query.plus_words.size() + query.minus_words.size() < MIN_PARALLEL_MATCH_WORDS) {
+        return MatchDocumentImpl(std::execution::seq, ordinal, query);
+    }
+    return MatchDocumentImpl(policy, ordinal, query);
+}
+
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> 
+    SearchServer::MatchDocument(std::string_view raw_query, int document_id) const{
+    const size_t ordinal = id_to_ordinal_.at(document_id);
+    return MatchDocumentImpl(std::execution::seq, ordinal, ParseQuerySimple(raw_query));
+}
+
+std::vector<std::string_view> SearchServer::MatchTerms(size_t ordinal, const std::vector<int>& plus_term_ids,
+                                                       const std::vector<int>& minus_term_ids) const {
+    const ArrayView<int> document_term_ids = forward_index_.GetTermIds(ordinal);
+    std::vector<std::string_view> matched_words;
 
-    if(std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), [this, document_id](std::string_view word){
-        return word_to_document_freqs_.at(word).count(document_id);
-    })){
-        matched_words.clear();
-        return {matched_words, documents_.at(document_id).status};
+    bool is_excluded = false;
+    IntersectTerms(document_term_ids, minus_term_ids, [&is_excluded](int){
+        is_excluded = true;
+    });
+    if (is_excluded) {
+        return matched_words;
     }
 
+    IntersectTerms(document_term_ids, plus_term_ids, [&](int term_id){
+        matched_words.push_back(terms_.GetTerm(term_id));
+    });
+    std::sort(matched_words.begin(), matched_words.end());
+    return matched_words;
+}
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    std::vector<int> snapshot_ordinals(documents_.size(), -1);
+    std::vector<SnapshotDocument> documents;
+    documents.reserve(id_to_ordinal_.size());
+    for (size_t ordinal = 0; ordinal < documents_.size(); ++ordinal) {
+        const DocumentData& document_data = documents_[ordinal];
+        const auto ordinal_it = id_to_ordinal_.find(document_data.id);
+        if (ordinal_it != id_to_ordinal_.end() && ordinal_it->second == ordinal) {
+            snapshot_ordinals[ordinal] = static_cast<int>(documents.size());
+            documents.push_back({document_data.id, document_data.rating, static_cast<int32_t>(document_data.status),
+                                 document_data.length});
+        }
+    }
 
-    auto last = std::copy_if(policy, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(), [this, document_id](std::string_view word){
-        return word_to_document_freqs_.at(word).count(document_id);
+    // terms sorted by text get ascending ids in LoadSnapshot, so it can append them to
+    // every forward index run in the term id order the runs need
+    std::vector<int> term_ids;
+    for (size_t term_id = 0; term_id < postings_.size(); ++term_id) {
+        if (!postings_[term_id].empty()) {
+            term_ids.push_back(static_cast<int>(term_id));
+        }
+    }
+    std::sort(term_ids.begin(), term_ids.end(), [this](int lhs, int rhs){
+        return terms_.GetTerm(lhs) < terms_.GetTerm(rhs);
     });
 
-    matched_words.erase(last, matched_words.end());
+    std::vector<SnapshotTerm> terms;
+    terms.reserve(term_ids.size());
+    std::string term_text;
+    std::vector<int32_t> ordinals;
+    std::vector<double> freqs;
+    for (int term_id : term_ids) {
+        const std::string_view term = terms_.GetTerm(term_id);
+        const PostingList& postings = postings_[term_id];
+        terms.push_back({term_text.size(), term.size(), ordinals.size(), postings.size()});
+        term_text.append(term);
+        postings.ForEach(0, INT_MAX, [&](int ordinal, double term_freq){
+            ordinals.push_back(snapshot_ordinals[ordinal]);
+            freqs.push_back(term_freq);
+        });
+    }
 
-    std::sort(matched_words.begin(), matched_words.end());
-    auto last_p = std::unique(matched_words.begin(), matched_words.end());
-    matched_words.erase(last_p, matched_words.end());
+    std::vector<uint32_t> stop_word_lengths;
+    std::string stop_word_text;
+    for (std::string_view word : stop_words_.GetWords()) {
+        stop_word_lengths.push_back(static_cast<uint32_t>(word.size()));
+        stop_word_text.append(word);
+    }
 
-    return {matched_words, documents_.at(document_id).status};
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.stop_word_count = stop_word_lengths.size();
+    header.stop_word_bytes = stop_word_text.size();
+    header.document_count = documents.size();
+    header.term_count = terms.size();
+    header.term_bytes = term_text.size();
+    header.posting_count = ordinals.size();
+
+    SnapshotWriter writer(path);
+    writer.WriteArray(&header, 1);
+    writer.WriteArray(stop_word_lengths.data(), stop_word_lengths.size());
+    writer.WriteArray(stop_word_text.data(), stop_word_text.size());
+    writer.WriteArray(documents.data(), documents.size());
+    writer.WriteArray(terms.data(), terms.size());
+    writer.WriteArray(term_text.data(), term_text.size());
+    writer.WriteArray(ordinals.data(), ordinals.size());
+    writer.WriteArray(freqs.data(), freqs.size());
+    writer.Finish();
 }
 
+SearchServer SearchServer::LoadSnapshot(const std::string& path) {
+    auto snapshot = std::make_shared<const MappedFile>(path);
+    SnapshotReader reader(snapshot->data(), snapshot->size());
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> 
-    SearchServer::MatchDocument(std::string_view raw_query, int document_id) const{
-    auto query = ParseQuery(raw_query);
-
-    std::vector<std::string_view> matched_words;
-    matched_words.reserve(query.plus_words.size());
+    const SnapshotHeader& header = *reader.ReadArray<SnapshotHeader>(1);
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0
+        || header.version != SNAPSHOT_VERSION || header.byte_order != SNAPSHOT_BYTE_ORDER) {
+        throw std::runtime_error(path + " is not a compatible snapshot"s);
+    }
+    const auto broken = [&path](){
+        return std::runtime_error(path + " is a broken snapshot"s);
+    };
+
+    const uint32_t* stop_word_lengths = reader.ReadArray<uint32_t>(header.stop_word_count);
+    const char* stop_word_text = reader.ReadArray<char>(header.stop_word_bytes);
+    const SnapshotDocument* documents = reader.ReadArray<SnapshotDocument>(header.document_count);
+    const SnapshotTerm* terms = reader.ReadArray<SnapshotTerm>(header.term_count);
+    const char* term_text = reader.ReadArray<char>(header.term_bytes);
+    const int32_t* ordinals = reader.ReadArray<int32_t>(header.posting_count);
+    const double* freqs = reader.ReadArray<double>(header.posting_count);
+    if (!reader.AtEnd()) {
+        throw broken();
+    }
 
-    for (std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            //matched_words.clear();
-            return {matched_words, documents_.at(document_id).status};
+    std::vector<std::string_view> stop_words;
+    uint64_t stop_word_offset = 0;
+    for (uint64_t i = 0; i < header.stop_word_count; ++i) {
+        if (stop_word_lengths[i] > header.stop_word_bytes - stop_word_offset) {
+            throw broken();
+        }
+        stop_words.emplace_back(stop_word_text + stop_word_offset, stop_word_lengths[i]);
+        stop_word_offset += stop_word_lengths[i];
+    }
+    SearchServer server(stop_words);
+    server.snapshot_ = snapshot;
+
+    server.documents_.reserve(header.document_count);
+    server.id_to_ordinal_.reserve(header.document_count);
+    for (uint64_t ordinal = 0; ordinal < header.document_count; ++ordinal) {
+        const SnapshotDocument& document = documents[ordinal];
+        if (document.id < 0 || document.status < 0 || document.status > static_cast<int32_t>(DocumentStatus::REMOVED)
+            || document.length < 0 || !server.id_to_ordinal_.emplace(document.id, ordinal).second) {
+            throw broken();
         }
+        server.documents_.push_back({document.id, document.rating, static_cast<DocumentStatus>(document.status),
+                                     document.length});
+        server.total_document_length_ += document.length;
+        server.document_ids_.insert(server.document_ids_.end(), document.id);
     }
 
+    server.terms_.Reserve(header.term_count);
+    server.postings_.reserve(header.term_count);
+    std::vector<size_t> document_term_counts(header.document_count, 0);
+    for (uint64_t i = 0; i < header.term_count; ++i) {
+        const SnapshotTerm& term = terms[i];
+        if (term.text_offset > header.term_bytes || term.text_length > header.term_bytes - term.text_offset
+            || term.posting_count == 0 || term.posting_offset > header.posting_count
+            || term.posting_count > header.posting_count - term.posting_offset) {
+            throw broken();
+        }
+        const std::string_view word(term_text + term.text_offset, term.text_length);
+        if (server.terms_.InternBorrowed(word) != static_cast<int>(i)) {
+            throw broken();
+        }
+        server.postings_.push_back(PostingList::Borrow(ordinals + term.posting_offset, freqs + term.posting_offset,
+                                                       term.posting_count));
+
+        int64_t previous_ordinal = -1;
+        for (uint64_t posting = term.posting_offset; posting < term.posting_offset + term.posting_count; ++posting) {
+            const int32_t ordinal = ordinals[posting];
+            if (ordinal <= previous_ordinal || static_cast<uint64_t>(ordinal) >= header.document_count) {
+                throw broken();
+            }
+            previous_ordinal = ordinal;
+            ++document_term_counts[ordinal];
+        }
+    }
 
-    for (std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.at(word).count(document_id)) {
-            matched_words.push_back(word);
+    // the forward index is not stored, it is the transposed inverted index; terms
+    // go in id order, so every document gets its terms sorted
+    server.forward_index_.Reset(document_term_counts);
+    for (uint64_t i = 0; i < header.term_count; ++i) {
+        const SnapshotTerm& term = terms[i];
+        for (uint64_t posting = term.posting_offset; posting < term.posting_offset + term.posting_count; ++posting) {
+            server.forward_index_.Append(ordinals[posting], static_cast<int>(i), freqs[posting]);
         }
     }
+    server.inverse_document_freqs_.SetDocumentCount(header.document_count);
+    server.inverse_document_freqs_.Invalidate();
 
-return {matched_words, documents_.at(document_id).status};
+    return server;
 }
\ No newline at end of file
@@ -15,18 +15,33 @@
 #include <execution>
 #include <string_view>
 #include <set>
+#include <unordered_map>
 #include <functional>
 #include <deque>
 #include <type_traits>
-#include "concurrent_map.h"
+#include "relevance_accumulator.h"
+#include "posting_list.h"
+#include "term_dictionary.h"
+#include "forward_index.h"
+#include "inverse_document_freq_table.h"
+#include "stop_words.h"
+#include "document_batch.h"
+#include "mapped_file.h"
+#include "top_documents.h"
+#include "scoring.h"
+#include "thread_pool.h"
 #include <future>
+#include <memory>
+#include <exception>
+#include <numeric>
+#include <thread>
+#include <cstdint>
+#include <limits>
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
 using namespace std::literals;
 
-#define SUM_NUMBER 1e-6
-
 class SearchServer {
 public:
 
@@ -53,22 +68,40 @@ public:
     void AddDocument(int document_id, std::string_view document, DocumentStatus status,
                      const std::vector<int>& ratings) ;
 
+    // Tokenises the whole batch under the policy, then indexes it in one pass.
+    // Nothing is added if any document of the batch is invalid
+    template<typename ExecutionPolicy>
+    void AddDocuments(ExecutionPolicy policy, const DocumentBatch& batch);
+
+    void AddDocuments(const DocumentBatch& batch);
+
+    // Adds every document of other for which filter(document_id) holds, with its
+    // term frequencies, rating and status as they are. Nothing is added if an id
+    // is already here
+    template <typename DocumentFilter>
+    void AddDocumentsFrom(const SearchServer& other, DocumentFilter filter);
+
+    // max_result_count limits the result size, the best documents are kept
     template <typename DocumentPredicate, typename Policy>
     std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query,
-                                      DocumentPredicate document_predicate) const ;
+                                      DocumentPredicate document_predicate,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
 
 
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query,
-                                      DocumentPredicate document_predicate) const ;
+                                      DocumentPredicate document_predicate,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
 
 
     template<typename Policy>
-    std::vector<Document> FindTopDocuments(Policy polity, std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(Policy polity, std::string_view raw_query, DocumentStatus status,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
 
 
-    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const{
-        return FindTopDocuments(std::execution::seq, raw_query, status);
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                      size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const{
+        return FindTopDocuments(std::execution::seq, raw_query, status, max_result_count);
     }
 
     template<typename Policy>
@@ -78,15 +111,113 @@ public:
         return FindTopDocuments(std::execution::seq, raw_query);
     }
 
+    // Scratch buffers of a query: parsed words, accumulators, cursors and the result.
+    // Passing the same context to many queries lets them run without allocating once
+    // the buffers have grown. One context serves one query at a time
+    class QueryContext;
+
+    // Same results as FindTopDocuments, computed in the buffers of context. The
+    // returned vector belongs to context and is overwritten by its next query
+    template <typename DocumentPredicate, typename Policy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, Policy policy, std::string_view raw_query,
+                                                  DocumentPredicate document_predicate,
+                                                  size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+
+    template <typename Policy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, Policy policy, std::string_view raw_query,
+                                                  DocumentStatus status,
+                                                  size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+
+    template <typename Policy>
+    const std::vector<Document>& FindTopDocuments(QueryContext& context, Policy policy, std::string_view raw_query) const {
+        return FindTopDocuments(context, policy, raw_query, DocumentStatus::ACTUAL);
+    }
+
+    // Like FindTopDocuments, but relevance comes from scoring, a model as described in
+    // scoring.h, e.g. Bm25Scoring. TfIdfScoring gives the same results as FindTopDocuments
+    template <typename Scoring, typename DocumentPredicate, typename Policy>
+    const std::vector<Document>& FindTopDocumentsScored(QueryContext& context, Policy policy,
+                                                        std::string_view raw_query, const Scoring& scoring,
+                                                        DocumentPredicate document_predicate,
+                                                        size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+
+    template <typename Scoring, typename DocumentPredicate, typename Policy>
+    std::vector<Document> FindTopDocumentsScored(Policy policy, std::string_view raw_query, const Scoring& scoring,
+                                                 DocumentPredicate document_predicate,
+                                                 size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+
+    template <typename Scoring, typename Policy>
+    std::vector<Document> FindTopDocumentsScored(Policy policy, std::string_view raw_query, const Scoring& scoring,
+                                                 DocumentStatus status,
+                                                 size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+
+    template <typename Scoring, typename Policy>
+    std::vector<Document> FindTopDocumentsScored(Policy policy, std::string_view raw_query,
+                                                 const Scoring& scoring) const {
+        return FindTopDocumentsScored(policy, raw_query, scoring, DocumentStatus::ACTUAL);
+    }
+
+    template <typename Scoring>
+    std::vector<Document> FindTopDocumentsScored(std::string_view raw_query, const Scoring& scoring) const {
+        return FindTopDocumentsScored(std::execution::seq, raw_query, scoring);
+    }
+
     int GetDocumentCount() const;
 
+    // Words per document without stop words, 0 for an empty index
+    double GetAverageDocumentLength() const;
+
+    bool HasDocument(int document_id) const {
+        return id_to_ordinal_.count(document_id) > 0;
+    }
+
+    // Number of documents containing word
+    size_t GetDocumentFreq(std::string_view word) const;
+
+    // Like FindTopDocuments, but word weights come from inverse_document_freq(word)
+    // instead of this index's own counts, so a part of a bigger index can score
+    // with the statistics of the whole. Called once per plus word present here
+    template <typename DocumentPredicate, typename InverseDocumentFreq, typename Policy>
+    std::vector<Document> FindTopDocumentsWithIdf(Policy policy, std::string_view raw_query,
+                                                  DocumentPredicate document_predicate,
+                                                  InverseDocumentFreq inverse_document_freq,
+                                                  size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const ;
+
+    // IDF values are cached per term. With max_drift above 0 a change of the document
+    // count is only taken up once it exceeds max_drift times the count they were
+    // computed for, which spares recomputing every term after each change at the cost
+    // of slightly stale weights. 0, the default, keeps results exact
+    void SetInverseDocumentFreqMaxDrift(double max_drift);
+
+    // Recomputes every cached IDF for the current document count
+    void RefreshInverseDocumentFreqs();
+
+    // Changes whenever the index changes in a way that can change search results.
+    // Generations come from one counter for the whole process, so a server assigned
+    // a different index, e.g. from LoadSnapshot, never keeps the old generation
+    uint64_t GetGeneration() const {
+        return generation_;
+    }
+
+    // Canonical form of the query: sorted distinct plus words, then sorted distinct
+    // minus words with their '-'. Queries with equal keys give equal results.
+    // Throws std::invalid_argument like FindTopDocuments
+    std::string NormalizeQuery(std::string_view raw_query) const;
+
     std::set<int>::iterator begin();
     std::set<int>::iterator end();
 
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // Words of the document with their frequencies, in term id order, not word order;
+    // empty for an unknown document. The view is valid until the index changes
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
-    //template<typename Policy>
+    // Plus words of the query found in the document, sorted and distinct, or none if it
+    // has a minus word. Words missing from the index match nothing. The words point
+    // into the index and stay valid while a document has them.
+    // Throws std::out_of_range for an unknown document.
+    // The par overload resolves words in parallel only for queries of at least
+    // MIN_PARALLEL_MATCH_WORDS words; shorter ones are cheaper done sequentially
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::parallel_policy policy, std::string_view raw_query,
                                                         int document_id) const ;
 
@@ -98,6 +229,18 @@ public:
         return MatchDocument(raw_query, document_id);
     }
 
+    // MatchDocument for every id of document_ids, in their order, with the query parsed
+    // and its words looked up once. Documents are matched in parallel under par.
+    // Throws std::out_of_range for unknown ids
+    template<typename ExecutionPolicy>
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>>
+    MatchDocuments(ExecutionPolicy policy, std::string_view raw_query, const std::vector<int>& document_ids) const ;
+
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>>
+    MatchDocuments(std::string_view raw_query, const std::vector<int>& document_ids) const {
+        return MatchDocuments(std::execution::seq, raw_query, document_ids);
+    }
+
     
 
     template<typename ExecutionPolicy>
@@ -107,30 +250,94 @@ public:
         RemoveDocument(std::execution::seq, document_id);
     }
 
-    static const int COUNT_BALLS = 8;
+    // Removes many documents at once: they are marked in a bitmap of ordinals and
+    // every affected posting list is compacted in a single pass, in parallel under
+    // par. Unknown ids are skipped. Once removed documents hold most of the
+    // ordinals, the rest are renumbered and the space of the removed ones freed
+    template<typename ExecutionPolicy>
+    void RemoveDocuments(ExecutionPolicy policy, const std::vector<int>& document_ids);
+
+    void RemoveDocuments(const std::vector<int>& document_ids) {
+        RemoveDocuments(std::execution::seq, document_ids);
+    }
+
+    // Writes stop words, documents, terms and postings to a versioned binary file.
+    // Removed documents are left out and the rest get consecutive ordinals.
+    // The file is replaced as a whole, so servers loaded from it keep their data
+    void SaveSnapshot(const std::string& path) const;
+
+    // Maps a file written by SaveSnapshot. Posting lists and term texts are read
+    // straight from the mapping; throws std::runtime_error for a broken file
+    static SearchServer LoadSnapshot(const std::string& path);
+
+    // Packs every long enough posting list into CompressedPostings blocks: several
+    // times less memory, term frequencies rounded to 16 bits of the largest one in
+    // their block of postings, see compressed_postings.h. Lists changed
+    // later by AddDocument or RemoveDocument go back to plain arrays
+    template<typename ExecutionPolicy>
+    void CompressPostings(ExecutionPolicy policy);
+
+    void CompressPostings() {
+        CompressPostings(std::execution::seq);
+    }
+
+    static const size_t MIN_PARALLEL_MATCH_WORDS = 256;
     
 private:
     struct DocumentData {
+        int id;
         int rating;
         DocumentStatus status;
+        int length; // words without stop words
     };
-    std::set<std::string> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_; // O(logW + logN)
+    StopWordSet stop_words_;
+    TermDictionary terms_;
+    InverseDocumentFreqTable inverse_document_freqs_; // by term id
+    std::vector<PostingList> postings_; // term id to its posting list of ordinals
     //std::map<std::string_view, int> word_to_document_;
-    std::map<int, DocumentData> documents_;
+    // Documents get dense ordinals 0..N-1 in the order they are added; everything
+    // below is indexed by ordinal, the external id is only needed at the API edge.
+    // Removed documents leave gaps until CompactOrdinals closes them
+    std::vector<DocumentData> documents_;
+    std::unordered_map<int, size_t> id_to_ordinal_;
     std::set<int> document_ids_;
-    std::map<int, std::map<std::string_view, double>> word_to_freqs_; // document_id to word to freqs  O(log N) + O(log W) = O(logN + logW)
+    ForwardIndex forward_index_; // ordinal to its term ids and frequencies
+    std::shared_ptr<const MappedFile> snapshot_; // backs borrowed terms and postings after LoadSnapshot
+    uint64_t total_document_length_ = 0; // of the documents still in the index
+    uint64_t generation_ = NextGeneration();
     //std::map<std::string, double> empty_map;
-    std::deque<std::string> dictionary_;
+
+    // A generation no server had before
+    static uint64_t NextGeneration();
 
     bool IsStopWord(std::string_view word) const ;
 
     static bool IsValidWord(std::string_view word);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const ;
+    // words becomes the words of text; it keeps its memory between calls
+    void SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const ;
 
     static int ComputeAverageRating(const std::vector<int>& ratings) ;
 
+    struct DocumentTerms {
+        std::vector<std::pair<std::string_view, double>> term_freqs; // sorted distinct words
+        int length = 0;
+    };
+
+    // Words of the document with their frequencies, touches no index state.
+    // result keeps its memory, so a reused one is filled without allocating
+    void ComputeTermFreqs(std::string_view document, DocumentTerms& result) const ;
+
+    void IndexDocument(int document_id, DocumentStatus status, int rating, const DocumentTerms& terms);
+
+    void CheckBatchIds(const DocumentBatch& batch) const ;
+
+    // Renumbers the live documents 0..N-1 in their order once removed ones hold more
+    // than half of the ordinals, so that memory and accumulator ranges follow the
+    // live count. Relative order, and with it every result, stays the same
+    template<typename ExecutionPolicy>
+    void CompactOrdinals(ExecutionPolicy policy);
+
     // template <typename StringContainer>
     // void AppendStopWords(const StringContainer& stop_words);
 
@@ -140,7 +347,8 @@ private:
         bool is_stop;
     };
 
-    QueryWord ParseQueryWord(std::string_view text) const ;
+    // is_valid tells that text has no control characters, the tokenizer knows it already
+    QueryWord ParseQueryWord(std::string_view text, bool is_valid) const ;
 
     struct Query {
         std::vector<std::string_view> plus_words;
@@ -150,12 +358,112 @@ private:
     Query ParseQuery(std::string_view text) const ;
     Query ParseQuerySimple(std::string_view text) const ;
 
-    // Existence required
-    double ComputeWordInverseDocumentFreq(std::string_view word) const ;
+    // Parse into result, with words as the tokenizer buffer; both keep their memory
+    void ParseQuery(std::string_view text, std::vector<std::string_view>& words, Query& result) const ;
+    void ParseQuerySimple(std::string_view text, std::vector<std::string_view>& words, Query& result) const ;
 
-    template <typename DocumentPredicate, typename Policy>
-    std::vector<Document> FindAllDocuments(Policy policy,
-        const Query& query, DocumentPredicate document_predicate) const ;
+    struct MaxScoreTerm {
+        PostingList::Cursor cursor;
+        double inverse_document_freq;
+        double max_relevance;
+        size_t query_index;
+    };
+
+    // Existence required, valid after PrepareInverseDocumentFreqs
+    double ComputeWordInverseDocumentFreq(int term_id) const {
+        return inverse_document_freqs_.Get(term_id, [this](int term_id){
+            return postings_[term_id].size();
+        });
+    }
+
+    // Brings the cached IDF values up to date before a query
+    void PrepareInverseDocumentFreqs() const ;
+
+    // term_ids becomes the ids of the indexed words, sorted and distinct; duplicates
+    // are dropped as integers, not as strings
+    void FindTermIds(const std::vector<std::string_view>& words, std::vector<int>& term_ids) const ;
+
+    // function(term_id) for every sorted query term among the sorted document terms;
+    // each binary search starts where the previous one stopped
+    template <typename Function>
+    static void IntersectTerms(ArrayView<int> document_term_ids, const std::vector<int>& term_ids, Function function);
+
+    // Words of plus_term_ids in the document, sorted, or none if it has one of
+    // minus_term_ids; both come from FindTermIds
+    std::vector<std::string_view> MatchTerms(size_t ordinal, const std::vector<int>& plus_term_ids,
+                                             const std::vector<int>& minus_term_ids) const ;
+
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus>
+    MatchDocumentImpl(ExecutionPolicy policy, size_t ordinal, const Query& query) const ;
+
+    // Number of scoring workers worth starting for a query touching posting_count postings
+    static size_t GetWorkerCount(size_t posting_count, size_t max_worker_count);
+
+    // Workers the policy can run at once
+    template <typename Policy>
+    static size_t GetMaxWorkerCount(Policy policy) {
+        if constexpr (std::is_same_v<std::decay_t<Policy>, std::execution::sequenced_policy>) {
+            return 1;
+        } else if constexpr (std::is_same_v<std::decay_t<Policy>, PoolPolicy>) {
+            return policy.GetPool().GetThreadCount();
+        } else {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+    }
+
+    // Postings of the known plus words of query
+    size_t CountPlusPostings(const Query& query) const ;
+
+    // The functions below take the parsed query from context.query_ and leave the
+    // top in context.top_documents_
+
+    // Document-at-a-time MaxScore evaluation: skips documents whose best possible
+    // relevance can not beat the current top, finds the same top as FindAllDocuments
+    template <typename DocumentPredicate, typename InverseDocumentFreq, typename Scorer>
+    void FindTopDocumentsMaxScore(QueryContext& context, DocumentPredicate document_predicate,
+                                  InverseDocumentFreq inverse_document_freq, const Scorer& scorer) const ;
+
+    // context.matches_ becomes ordinal to relevance of every document passing the
+    // query and predicate, in ordinal order
+    template <typename DocumentPredicate, typename InverseDocumentFreq, typename Scorer, typename Policy>
+    void FindAllDocuments(QueryContext& context, Policy policy, DocumentPredicate document_predicate,
+                          InverseDocumentFreq inverse_document_freq, const Scorer& scorer) const ;
+
+    // inverse_document_freq(term_id) gives the weight of a query term, scorer is
+    // a prepared scoring model
+    template <typename DocumentPredicate, typename InverseDocumentFreq, typename Scorer, typename Policy>
+    const std::vector<Document>& FindTopDocumentsParsed(QueryContext& context, Policy policy,
+                                                        DocumentPredicate document_predicate,
+                                                        InverseDocumentFreq inverse_document_freq,
+                                                        const Scorer& scorer, size_t max_result_count) const ;
+};
+
+class SearchServer::QueryContext {
+public:
+    QueryContext() = default;
+
+private:
+    friend class SearchServer;
+
+    std::vector<std::string_view> words_;
+    Query query_;
+    TopDocuments top_documents_{0};
+
+    // FindAllDocuments
+    std::vector<const PostingList*> plus_postings_;
+    std::vector<const PostingList*> minus_postings_;
+    std::vector<double> inverse_document_freqs_;
+    std::vector<RelevanceAccumulator> accumulators_;
+    std::vector<size_t> workers_;
+    std::vector<std::pair<size_t, double>> matches_;
+
+    // FindTopDocumentsMaxScore
+    std::vector<MaxScoreTerm> terms_;
+    std::vector<PostingList::Cursor> minus_cursors_;
+    std::vector<double> max_relevance_prefix_;
+    std::vector<double> contributions_;
+    std::vector<char> is_contributing_;
 };
 
 
@@ -165,13 +473,13 @@ private:
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words) // Extract non-empty stop words
 {
-    for(std::string_view word : MakeUniqueNonEmptyStrings(stop_words)){
-        stop_words_.insert(std::move(std::string(word)));
-    }
+    const auto unique_stop_words = MakeUniqueNonEmptyStrings(stop_words);
 
-    if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
+    if (!all_of(unique_stop_words.begin(), unique_stop_words.end(), IsValidWord)) {
         throw std::invalid_argument("Some of stop words are invalid"s);
     }
+
+    stop_words_ = StopWordSet(unique_stop_words);
 }
 
 
@@ -180,42 +488,118 @@ SearchServer::SearchServer(const StringContainer& stop_words) // Extract non-emp
 
 template <typename DocumentPredicate, typename Policy>
     std::vector<Document> SearchServer::FindTopDocuments(Policy policy, std::string_view raw_query,
-                                      DocumentPredicate document_predicate) const {
+                                      DocumentPredicate document_predicate, size_t max_result_count) const {
+    QueryContext context;
+    FindTopDocuments(context, policy, raw_query, document_predicate, max_result_count);
+    return context.top_documents_.TakeSorted();
+}
 
-    const auto query = ParseQuery(raw_query);
-    
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-    
-    sort(policy, matched_documents.begin(), matched_documents.end(),
-            [](const Document& lhs, const Document& rhs) {
-                if (std::abs(lhs.relevance - rhs.relevance) < SUM_NUMBER) {
-                    return lhs.rating > rhs.rating;
-                } else {
-                    return lhs.relevance > rhs.relevance;
-                }
-    });
-    
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename DocumentPredicate, typename Policy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, Policy policy,
+                                                            std::string_view raw_query,
+                                                            DocumentPredicate document_predicate,
+                                                            size_t max_result_count) const {
+    return FindTopDocumentsScored(context, policy, raw_query, TfIdfScoring(), document_predicate, max_result_count);
+}
+
+template <typename Scoring, typename DocumentPredicate, typename Policy>
+const std::vector<Document>& SearchServer::FindTopDocumentsScored(QueryContext& context, Policy policy,
+                                                                  std::string_view raw_query, const Scoring& scoring,
+                                                                  DocumentPredicate document_predicate,
+                                                                  size_t max_result_count) const {
+    ParseQuery(raw_query, context.words_, context.query_);
+    PrepareInverseDocumentFreqs();
+    const auto scorer = scoring.Prepare(CorpusStats{GetAverageDocumentLength()});
+    return FindTopDocumentsParsed(context, policy, document_predicate, [this](int term_id){
+        return ComputeWordInverseDocumentFreq(term_id);
+    }, scorer, max_result_count);
+}
+
+template <typename Scoring, typename DocumentPredicate, typename Policy>
+std::vector<Document> SearchServer::FindTopDocumentsScored(Policy policy, std::string_view raw_query,
+                                                           const Scoring& scoring,
+                                                           DocumentPredicate document_predicate,
+                                                           size_t max_result_count) const {
+    QueryContext context;
+    FindTopDocumentsScored(context, policy, raw_query, scoring, document_predicate, max_result_count);
+    return context.top_documents_.TakeSorted();
+}
+
+template <typename Scoring, typename Policy>
+std::vector<Document> SearchServer::FindTopDocumentsScored(Policy policy, std::string_view raw_query,
+                                                           const Scoring& scoring, DocumentStatus status,
+                                                           size_t max_result_count) const {
+    return FindTopDocumentsScored(policy, raw_query, scoring, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    }, max_result_count);
+}
+
+template <typename Policy>
+const std::vector<Document>& SearchServer::FindTopDocuments(QueryContext& context, Policy policy,
+                                                            std::string_view raw_query, DocumentStatus status,
+                                                            size_t max_result_count) const {
+    return FindTopDocuments(context, policy, raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    }, max_result_count);
+}
+
+template <typename DocumentPredicate, typename InverseDocumentFreq, typename Policy>
+std::vector<Document> SearchServer::FindTopDocumentsWithIdf(Policy policy, std::string_view raw_query,
+                                                            DocumentPredicate document_predicate,
+                                                            InverseDocumentFreq inverse_document_freq,
+                                                            size_t max_result_count) const {
+    QueryContext context;
+    ParseQuery(raw_query, context.words_, context.query_);
+    FindTopDocumentsParsed(context, policy, document_predicate, [&](int term_id){
+        return inverse_document_freq(terms_.GetTerm(term_id));
+    }, TfIdfScoring(), max_result_count);
+    return context.top_documents_.TakeSorted();
+}
+
+template <typename DocumentPredicate, typename InverseDocumentFreq, typename Scorer, typename Policy>
+const std::vector<Document>& SearchServer::FindTopDocumentsParsed(QueryContext& context, Policy policy,
+                                                                  DocumentPredicate document_predicate,
+                                                                  InverseDocumentFreq inverse_document_freq,
+                                                                  const Scorer& scorer, size_t max_result_count) const {
+    context.top_documents_.Reset(max_result_count);
+
+    // a query too light to split gains nothing from FindAllDocuments: its single
+    // accumulator would span every ordinal, and on a pool its worker is better left
+    // to the other queries of the batch
+    bool is_whole_query = true;
+    if constexpr (!std::is_same_v<std::decay_t<Policy>, std::execution::sequenced_policy>) {
+        is_whole_query = GetWorkerCount(CountPlusPostings(context.query_), GetMaxWorkerCount(policy)) == 1;
     }
 
-    return matched_documents;
+    if (is_whole_query) {
+        FindTopDocumentsMaxScore(context, document_predicate, inverse_document_freq, scorer);
+    } else {
+        FindAllDocuments(context, policy, document_predicate, inverse_document_freq, scorer);
+
+        // bounded selection instead of sorting every match
+        for (const auto& [ordinal, relevance] : context.matches_) {
+            const DocumentData& document_data = documents_[ordinal];
+            context.top_documents_.Push(Document(document_data.id, relevance, document_data.rating));
+        }
+    }
 
+    return context.top_documents_.Sort();
 }
 
 
 template <typename DocumentPredicate>
     std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query,
-DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+DocumentPredicate document_predicate, size_t max_result_count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_result_count);
 }
 
 template<typename Policy>
-std::vector<Document> SearchServer::FindTopDocuments(Policy policy, std::string_view raw_query, DocumentStatus status) const {
+std::vector<Document> SearchServer::FindTopDocuments(Policy policy, std::string_view raw_query, DocumentStatus status,
+                                                     size_t max_result_count) const {
 return FindTopDocuments(policy,
     raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
         return document_status == status;
-    });
+    }, max_result_count);
 }   
 
 template<typename Policy>
@@ -223,74 +607,516 @@ template<typename Policy>
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-template <typename DocumentPredicate, typename Policy>
-std::vector<Document> SearchServer::FindAllDocuments(Policy policy, const Query& query,
-                                    DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(8);
+template <typename DocumentPredicate, typename InverseDocumentFreq, typename Scorer, typename Policy>
+void SearchServer::FindAllDocuments(QueryContext& context, Policy policy,
+                                    DocumentPredicate document_predicate,
+                                    InverseDocumentFreq inverse_document_freq, const Scorer& scorer) const {
+    const Query& query = context.query_;
+    auto& ordinal_to_relevance = context.matches_;
+    auto& plus_postings = context.plus_postings_;
+    auto& inverse_document_freqs = context.inverse_document_freqs_;
+    auto& minus_postings = context.minus_postings_;
+    ordinal_to_relevance.clear();
+    plus_postings.clear();
+    inverse_document_freqs.clear();
+    minus_postings.clear();
+
+    size_t posting_count = 0;
+    for (std::string_view word : query.plus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != TermDictionary::NO_TERM) {
+            plus_postings.push_back(&postings_[term_id]);
+            inverse_document_freqs.push_back(inverse_document_freq(term_id));
+            posting_count += postings_[term_id].size();
+        }
+    }
+    if (plus_postings.empty()) {
+        return;
+    }
 
+    for (std::string_view word : query.minus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != TermDictionary::NO_TERM) {
+            minus_postings.push_back(&postings_[term_id]);
+        }
+    }
 
-    std::for_each(policy,query.plus_words.begin(), query.plus_words.end(), [&](std::string_view word){
+    // Every worker owns a contiguous range of ordinals and its own accumulator,
+    // so nothing is shared while scoring and each document sums its terms in query order
+    const size_t worker_count = GetWorkerCount(posting_count, GetMaxWorkerCount(policy));
+    const size_t ordinal_count = documents_.size();
+
+    auto& accumulators = context.accumulators_;
+    auto& workers = context.workers_;
+    accumulators.resize(worker_count);
+    workers.resize(worker_count);
+    std::iota(workers.begin(), workers.end(), 0);
+
+    ForEachTask(policy, workers.begin(), workers.end(), [&](size_t worker){
+        const int range_begin = static_cast<int>(ordinal_count * worker / worker_count);
+        const int range_end = static_cast<int>(ordinal_count * (worker + 1) / worker_count);
+        RelevanceAccumulator& accumulator = accumulators[worker];
+        accumulator.Reset(range_begin, range_end);
+
+        // minus words go first, so excluded documents are never scored
+        for (const PostingList* postings : minus_postings) {
+            postings->ForEach(range_begin, range_end, [&accumulator](int ordinal, double){
+                accumulator.Exclude(ordinal);
+            });
+        }
 
-        if (word_to_document_freqs_.count(word)) {
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+        for (size_t term = 0; term < plus_postings.size(); ++term) {
+            const double term_inverse_document_freq = inverse_document_freqs[term];
+            plus_postings[term]->ForEach(range_begin, range_end, [&](int ordinal, double term_freq){
+                if (accumulator.IsExcluded(ordinal)) {
+                    return;
                 }
-            }
+                const DocumentData& document_data = documents_[ordinal];
+                if (document_predicate(document_data.id, document_data.status, document_data.rating)) {
+                    accumulator.Add(ordinal, scorer.Score(term_freq, term_inverse_document_freq, document_data.length));
+                }
+            });
         }
+
+        // a fixed order makes ties resolve the same way in every evaluation strategy
+        accumulator.SortMatched();
     });
 
-    
-   std::for_each(policy, query.minus_words.begin(), query.minus_words.end(), [&](std::string_view word){
-        if (word_to_document_freqs_.count(word) ) {
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-                document_to_relevance.erase(document_id);
+    size_t matched_count = 0;
+    for (const RelevanceAccumulator& accumulator : accumulators) {
+        matched_count += accumulator.size();
+    }
+    ordinal_to_relevance.reserve(matched_count);
+    for (const RelevanceAccumulator& accumulator : accumulators) {
+        accumulator.ForEach([&ordinal_to_relevance](size_t ordinal, double relevance){
+            ordinal_to_relevance.emplace_back(ordinal, relevance);
+        });
+    }
+
+}
+
+template <typename DocumentPredicate, typename InverseDocumentFreq, typename Scorer>
+void SearchServer::FindTopDocumentsMaxScore(QueryContext& context, DocumentPredicate document_predicate,
+                                            InverseDocumentFreq inverse_document_freq, const Scorer& scorer) const {
+    const Query& query = context.query_;
+    auto& terms = context.terms_;
+    auto& minus_cursors = context.minus_cursors_;
+    terms.clear();
+    minus_cursors.clear();
+
+    for (size_t query_index = 0; query_index < query.plus_words.size(); ++query_index) {
+        const int term_id = terms_.Find(query.plus_words[query_index]);
+        if (term_id != TermDictionary::NO_TERM) {
+            const double term_inverse_document_freq = inverse_document_freq(term_id);
+            terms.push_back({PostingList::Cursor(postings_[term_id]), term_inverse_document_freq,
+                             scorer.GetMaxScore(postings_[term_id].GetMaxFreq(), term_inverse_document_freq),
+                             query_index});
+        }
+    }
+
+    for (std::string_view word : query.minus_words) {
+        const int term_id = terms_.Find(word);
+        if (term_id != TermDictionary::NO_TERM) {
+            minus_cursors.emplace_back(postings_[term_id]);
+        }
+    }
+
+    TopDocuments& top_documents = context.top_documents_;
+    // a full collector here can hold no documents at all
+    if (terms.empty() || top_documents.IsFull()) {
+        return;
+    }
+
+    // terms[0..first_essential) can not lift a document into the top on their own,
+    // so only the essential rest proposes candidates
+    std::sort(terms.begin(), terms.end(), [](const MaxScoreTerm& lhs, const MaxScoreTerm& rhs){
+        return lhs.max_relevance < rhs.max_relevance;
+    });
+    auto& max_relevance_prefix = context.max_relevance_prefix_;
+    max_relevance_prefix.resize(terms.size());
+    double max_relevance_sum = 0.0;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        max_relevance_sum += terms[i].max_relevance;
+        max_relevance_prefix[i] = max_relevance_sum;
+    }
+
+    // A document can only displace the worst kept one if its relevance is within
+    // SUM_NUMBER of it (then the rating decides) or above; the margin absorbs rounding
+    // in the bound sums
+    const double pruning_margin = 1e-9;
+    double threshold = -std::numeric_limits<double>::infinity();
+    size_t first_essential = 0;
+
+    // relevance parts per query word, summed in query order like FindAllDocuments does
+    auto& contributions = context.contributions_;
+    auto& is_contributing = context.is_contributing_;
+    contributions.assign(query.plus_words.size(), 0.0);
+    is_contributing.assign(query.plus_words.size(), false);
+
+    int next_ordinal = 0;
+    while (true) {
+        // the threshold may also drop when a close document with a better rating
+        // replaces the worst one, so the essential boundary is recomputed every time
+        while (first_essential > 0 && max_relevance_prefix[first_essential - 1] + pruning_margin > threshold) {
+            --first_essential;
+        }
+        while (first_essential < terms.size() && max_relevance_prefix[first_essential] + pruning_margin <= threshold) {
+            ++first_essential;
+        }
+
+        int candidate = std::numeric_limits<int>::max();
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            terms[i].cursor.SkipTo(next_ordinal);
+            if (!terms[i].cursor.AtEnd()) {
+                candidate = std::min(candidate, terms[i].cursor.GetId());
             }
         }
-   });
+        if (candidate == std::numeric_limits<int>::max()) {
+            break;
+        }
+        next_ordinal = candidate + 1;
+
+        bool is_excluded = false;
+        for (PostingList::Cursor& cursor : minus_cursors) {
+            cursor.SkipTo(candidate);
+            if (!cursor.AtEnd() && cursor.GetId() == candidate) {
+                is_excluded = true;
+                break;
+            }
+        }
+        const DocumentData& document_data = documents_[candidate];
+        if (is_excluded || !document_predicate(document_data.id, document_data.status, document_data.rating)) {
+            continue;
+        }
+
+        std::fill(is_contributing.begin(), is_contributing.end(), false);
+        double relevance_bound = 0.0;
+        for (size_t i = first_essential; i < terms.size(); ++i) {
+            MaxScoreTerm& term = terms[i];
+            if (!term.cursor.AtEnd() && term.cursor.GetId() == candidate) {
+                contributions[term.query_index] = scorer.Score(term.cursor.GetFreq(), term.inverse_document_freq,
+                                                               document_data.length);
+                is_contributing[term.query_index] = true;
+                relevance_bound += contributions[term.query_index];
+            }
+        }
+
+        // non-essential terms from the strongest, while they can still matter
+        bool is_pruned = false;
+        for (size_t i = first_essential; i-- > 0;) {
+            if (relevance_bound + max_relevance_prefix[i] + pruning_margin <= threshold) {
+                is_pruned = true;
+                break;
+            }
+            MaxScoreTerm& term = terms[i];
+            term.cursor.SkipTo(candidate);
+            if (!term.cursor.AtEnd() && term.cursor.GetId() == candidate) {
+                contributions[term.query_index] = scorer.Score(term.cursor.GetFreq(), term.inverse_document_freq,
+                                                               document_data.length);
+                is_contributing[term.query_index] = true;
+                relevance_bound += contributions[term.query_index];
+            }
+        }
+        if (is_pruned || relevance_bound + pruning_margin <= threshold) {
+            continue;
+        }
 
+        double relevance = 0.0;
+        for (size_t query_index = 0; query_index < contributions.size(); ++query_index) {
+            if (is_contributing[query_index]) {
+                relevance += contributions[query_index];
+            }
+        }
+        top_documents.Push(Document(document_data.id, relevance, document_data.rating));
+        if (top_documents.IsFull()) {
+            threshold = top_documents.Worst().relevance - SUM_NUMBER;
+        }
+    }
+
+}
+
+template <typename Function>
+void SearchServer::IntersectTerms(ArrayView<int> document_term_ids, const std::vector<int>& term_ids,
+                                  Function function) {
+    const int* document_it = document_term_ids.begin();
+    for (int term_id : term_ids) {
+        document_it = std::lower_bound(document_it, document_term_ids.end(), term_id);
+        if (document_it == document_term_ids.end()) {
+            return;
+        }
+        if (*document_it == term_id) {
+            function(term_id);
+        }
+    }
+}
+
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus>
+SearchServer::MatchDocumentImpl(ExecutionPolicy policy, size_t ordinal, const Query& query) const {
+    const ArrayView<int> document_term_ids = forward_index_.GetTermIds(ordinal);
+    // a dictionary probe and a binary search per word, NO_TERM if the document lacks it
+    const auto find_document_term = [&](std::string_view word){
+        const int term_id = terms_.Find(word);
+        if (term_id == TermDictionary::NO_TERM
+            || !std::binary_search(document_term_ids.begin(), document_term_ids.end(), term_id)) {
+            return TermDictionary::NO_TERM;
+        }
+        return term_id;
+    };
+
+    std::vector<std::string_view> matched_words;
+    if (std::any_of(policy, query.minus_words.begin(), query.minus_words.end(), [&](std::string_view word){
+        return find_document_term(word) != TermDictionary::NO_TERM;
+    })) {
+        return {matched_words, documents_[ordinal].status};
+    }
+
+    std::vector<int> matched_term_ids(query.plus_words.size());
+    std::transform(policy, query.plus_words.begin(), query.plus_words.end(), matched_term_ids.begin(),
+                   find_document_term);
+    // only the matches are deduplicated, as integers
+    matched_term_ids.erase(std::remove(matched_term_ids.begin(), matched_term_ids.end(), TermDictionary::NO_TERM),
+                           matched_term_ids.end());
+    std::sort(matched_term_ids.begin(), matched_term_ids.end());
+    matched_term_ids.erase(std::unique(matched_term_ids.begin(), matched_term_ids.end()), matched_term_ids.end());
+
+    matched_words.reserve(matched_term_ids.size());
+    for (int term_id : matched_term_ids) {
+        matched_words.push_back(terms_.GetTerm(term_id));
+    }
+    std::sort(matched_words.begin(), matched_words.end());
+    return {matched_words, documents_[ordinal].status};
+}
+
+template<typename ExecutionPolicy>
+std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>>
+SearchServer::MatchDocuments(ExecutionPolicy policy, std::string_view raw_query,
+                             const std::vector<int>& document_ids) const {
+    // everything that can throw happens here, never inside the parallel loop
+    std::vector<size_t> ordinals;
+    ordinals.reserve(document_ids.size());
+    for (int document_id : document_ids) {
+        ordinals.push_back(id_to_ordinal_.at(document_id));
+    }
+    const Query query = ParseQuerySimple(raw_query);
+    std::vector<int> plus_term_ids;
+    std::vector<int> minus_term_ids;
+    FindTermIds(query.plus_words, plus_term_ids);
+    FindTermIds(query.minus_words, minus_term_ids);
+
+    std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>> results(ordinals.size());
+    std::transform(policy, ordinals.begin(), ordinals.end(), results.begin(), [&](size_t ordinal){
+        return std::tuple(MatchTerms(ordinal, plus_term_ids, minus_term_ids), documents_[ordinal].status);
+    });
+    return results;
+}
 
-    auto temp_map = document_to_relevance.BuildOrdinaryMap();
-        
-    int size = temp_map.size();
-         
-    std::vector<Document> matched_documents(size);
+template<typename ExecutionPolicy>
+void SearchServer::AddDocuments(ExecutionPolicy policy, const DocumentBatch& batch) {
+    CheckBatchIds(batch);
 
-    int actual_size = 0;
-    std::transform(temp_map.begin(), temp_map.end(), matched_documents.begin(), [this, &actual_size](auto i){
-        actual_size++;
-        return Document(i.first, i.second, documents_.at(i.first).rating);
+    struct TokenizedDocument {
+        DocumentTerms terms;
+        int rating = 0;
+        std::exception_ptr error;
+    };
+    std::vector<TokenizedDocument> tokenized(batch.size());
+
+    // an exception must not leave a parallel algorithm, so it is kept and rethrown below
+    std::transform(policy, batch.documents_.begin(), batch.documents_.end(), tokenized.begin(),
+                   [this](const DocumentBatch::Entry& entry){
+        TokenizedDocument result;
+        try {
+            ComputeTermFreqs(entry.text, result.terms);
+            result.rating = ComputeAverageRating(entry.ratings);
+        } catch (...) {
+            result.error = std::current_exception();
+        }
+        return result;
     });
 
-    matched_documents.resize(actual_size);
+    for (const TokenizedDocument& document : tokenized) {
+        if (document.error) {
+            std::rethrow_exception(document.error);
+        }
+    }
 
-    return matched_documents;
+    size_t term_count = 0;
+    for (const TokenizedDocument& document : tokenized) {
+        term_count += document.terms.term_freqs.size();
+    }
+    documents_.reserve(documents_.size() + batch.size());
+    forward_index_.Reserve(forward_index_.size() + batch.size(), term_count);
+    for (size_t i = 0; i < tokenized.size(); ++i) {
+        const auto& entry = batch.documents_[i];
+        IndexDocument(entry.id, entry.status, tokenized[i].rating, tokenized[i].terms);
+    }
+}
+
+template <typename DocumentFilter>
+void SearchServer::AddDocumentsFrom(const SearchServer& other, DocumentFilter filter) {
+    std::vector<size_t> ordinals;
+    for (const auto [document_id, ordinal] : other.id_to_ordinal_) {
+        if (filter(document_id)) {
+            if (id_to_ordinal_.count(document_id) > 0) {
+                throw std::invalid_argument("Invalid document_id"s);
+            }
+            ordinals.push_back(ordinal);
+        }
+    }
+    // keep the relative order of other
+    std::sort(ordinals.begin(), ordinals.end());
+
+    documents_.reserve(documents_.size() + ordinals.size());
+    DocumentTerms terms;
+    for (size_t ordinal : ordinals) {
+        const DocumentData& document_data = other.documents_[ordinal];
+        const ArrayView<int> term_ids = other.forward_index_.GetTermIds(ordinal);
+        const ArrayView<double> term_freqs = other.forward_index_.GetTermFreqs(ordinal);
+        terms.term_freqs.clear();
+        for (size_t i = 0; i < term_ids.size(); ++i) {
+            terms.term_freqs.emplace_back(other.terms_.GetTerm(term_ids[i]), term_freqs[i]);
+        }
+        terms.length = document_data.length;
+        IndexDocument(document_data.id, document_data.status, document_data.rating, terms);
+    }
 }
 
 template<typename ExecutionPolicy>
-void SearchServer::RemoveDocument(ExecutionPolicy policy, int document_id){
+void SearchServer::CompressPostings(ExecutionPolicy policy) {
+    // quantised frequencies shift relevance slightly
+    generation_ = NextGeneration();
+    std::for_each(policy, postings_.begin(), postings_.end(), [](PostingList& postings){
+        postings.Compress();
+    });
+}
 
-    auto& word_freq = word_to_freqs_[document_id]; //  O(log N)   нашли мапу слово-частота 
+template<typename ExecutionPolicy>
+void SearchServer::RemoveDocument(ExecutionPolicy policy, int document_id){
 
+    const auto ordinal_it = id_to_ordinal_.find(document_id);
+    if (ordinal_it == id_to_ordinal_.end()) {
+        return;
+    }
+    const size_t ordinal = ordinal_it->second;
+    generation_ = NextGeneration();
 
-    std::vector<std::string_view> v_words(word_freq.size());
+    // stays intact until the document is cleared below
+    const ArrayView<int> term_ids = forward_index_.GetTermIds(ordinal);
 
-    std::transform(policy, word_freq.begin(), word_freq.end(), v_words.begin(), [](auto& word){
-      return word.first;                                                                            
+    // every term is distinct, so each thread touches its own posting list
+    std::for_each(policy, term_ids.begin(), term_ids.end(), [&](int term_id){
+        postings_[term_id].Erase(ordinal);
     });
 
-    std::for_each(policy, v_words.begin(), v_words.end(), [&](std::string_view word){
-    
-        word_to_document_freqs_[word].erase(document_id);
+    // terms no document uses any more leave the dictionary
+    for (int term_id : term_ids) {
+        inverse_document_freqs_.MarkTerm(term_id);
+        if (postings_[term_id].empty()) {
+            postings_[term_id] = PostingList();
+            terms_.Release(term_id);
+        }
+    }
+
+
+    document_ids_.erase(document_id);
+
+    // the ordinal is not reused, its slot just stops being referenced by any posting
+    id_to_ordinal_.erase(ordinal_it);
+    total_document_length_ -= documents_[ordinal].length;
+    inverse_document_freqs_.SetDocumentCount(id_to_ordinal_.size());
+
+    forward_index_.Clear(ordinal);
+    CompactOrdinals(policy);
+}
+
+template<typename ExecutionPolicy>
+void SearchServer::RemoveDocuments(ExecutionPolicy policy, const std::vector<int>& document_ids) {
+    std::vector<uint64_t> removed_ordinals((documents_.size() + 63) / 64, 0);
+    const auto is_removed = [&removed_ordinals](size_t ordinal){
+        return (removed_ordinals[ordinal / 64] >> (ordinal % 64)) & 1;
+    };
+
+    std::vector<size_t> ordinals;
+    ordinals.reserve(document_ids.size());
+    for (int document_id : document_ids) {
+        const auto ordinal_it = id_to_ordinal_.find(document_id);
+        if (ordinal_it == id_to_ordinal_.end()) {
+            continue;
+        }
+        const size_t ordinal = ordinal_it->second;
+        removed_ordinals[ordinal / 64] |= uint64_t(1) << (ordinal % 64);
+        ordinals.push_back(ordinal);
+        total_document_length_ -= documents_[ordinal].length;
+        id_to_ordinal_.erase(ordinal_it);
+        document_ids_.erase(document_id);
+    }
+    if (ordinals.empty()) {
+        return;
+    }
+    generation_ = NextGeneration();
+
+    // each affected list once, however many removed documents it holds
+    std::vector<char> is_affected(terms_.GetIdLimit(), false);
+    std::vector<int> affected_term_ids;
+    for (size_t ordinal : ordinals) {
+        for (int term_id : forward_index_.GetTermIds(ordinal)) {
+            if (!is_affected[term_id]) {
+                is_affected[term_id] = true;
+                affected_term_ids.push_back(term_id);
+            }
+        }
+    }
+
+    std::for_each(policy, affected_term_ids.begin(), affected_term_ids.end(), [&](int term_id){
+        postings_[term_id].EraseIf(is_removed);
     });
+    for (size_t ordinal : ordinals) {
+        forward_index_.Clear(ordinal);
+    }
 
+    for (int term_id : affected_term_ids) {
+        inverse_document_freqs_.MarkTerm(term_id);
+        if (postings_[term_id].empty()) {
+            postings_[term_id] = PostingList();
+            terms_.Release(term_id);
+        }
+    }
+    inverse_document_freqs_.SetDocumentCount(id_to_ordinal_.size());
+    CompactOrdinals(policy);
+}
 
-    auto it = std::find(policy, document_ids_.begin(), document_ids_.end(), document_id);
-    document_ids_.erase(it); // log(N)
+template<typename ExecutionPolicy>
+void SearchServer::CompactOrdinals(ExecutionPolicy policy) {
+    // the whole index is rewritten, so at least half of it must be garbage
+    if ((documents_.size() - id_to_ordinal_.size()) * 2 <= documents_.size()) {
+        return;
+    }
 
-    documents_.erase( documents_.find(document_id));
+    std::vector<int> new_ordinals(documents_.size(), -1);
+    std::vector<size_t> live_ordinals;
+    std::vector<DocumentData> documents;
+    live_ordinals.reserve(id_to_ordinal_.size());
+    documents.reserve(id_to_ordinal_.size());
+    for (size_t ordinal = 0; ordinal < documents_.size(); ++ordinal) {
+        // a removed id may be back under a newer ordinal
+        const auto ordinal_it = id_to_ordinal_.find(documents_[ordinal].id);
+        if (ordinal_it != id_to_ordinal_.end() && ordinal_it->second == ordinal) {
+            new_ordinals[ordinal] = static_cast<int>(live_ordinals.size());
+            ordinal_it->second = live_ordinals.size();
+            live_ordinals.push_back(ordinal);
+            documents.push_back(documents_[ordinal]);
+        }
+    }
 
-    word_to_freqs_.erase(word_to_freqs_.find(document_id));
+    // postings only hold live ordinals, and the new ones keep their order
+    std::for_each(policy, postings_.begin(), postings_.end(), [&new_ordinals](PostingList& postings){
+        if (!postings.empty()) {
+            postings.RemapIds([&new_ordinals](int ordinal){
+                return new_ordinals[ordinal];
+            });
+        }
+    });
+    forward_index_.Compact(live_ordinals);
+    documents_ = std::move(documents);
 }
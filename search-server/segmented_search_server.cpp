@@ -0,0 +1,237 @@
+#include "segmented_search_server.h"
+
+SegmentedSearchServer::SegmentedSearchServer(SearchServer empty_index, size_t write_segment_size)
+    : empty_index_(std::move(empty_index))
+    , write_segment_size_(std::max<size_t>(write_segment_size, 1))
+    , write_segment_(empty_index_) {
+    if (empty_index_.GetDocumentCount() > 0) {
+        throw std::invalid_argument("Segment template must be empty"s);
+    }
+    merger_ = std::thread([this]{
+        RunMerges();
+    });
+}
+
+SegmentedSearchServer::~SegmentedSearchServer() {
+    {
+        std::unique_lock lock(mutex_);
+        is_stopping_ = true;
+    }
+    merge_needed_.notify_all();
+    merger_.join();
+}
+
+void SegmentedSearchServer::Segment::AddTombstone(int document_id) {
+    if (!removed_ids.insert(document_id).second) {
+        return;
+    }
+    for (const auto& [word, term_freq] : index->GetWordFrequencies(document_id)) {
+        ++removed_document_freqs[word];
+    }
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                        const std::vector<int>& ratings) {
+    std::unique_lock lock(mutex_);
+    for (const auto& segment : segments_) {
+        if (segment->HasLiveDocument(document_id)) {
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+    }
+    write_segment_.AddDocument(document_id, document, status, ratings);
+    ++document_count_;
+
+    if (static_cast<size_t>(write_segment_.GetDocumentCount()) >= write_segment_size_) {
+        SealWriteSegment();
+    }
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id) {
+    std::unique_lock lock(mutex_);
+    if (write_segment_.HasDocument(document_id)) {
+        write_segment_.RemoveDocument(document_id);
+        --document_count_;
+        return;
+    }
+    RemoveSealedDocument(document_id);
+}
+
+void SegmentedSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    std::unique_lock lock(mutex_);
+    std::vector<int> write_segment_ids;
+    for (int document_id : document_ids) {
+        if (write_segment_.HasDocument(document_id)) {
+            write_segment_ids.push_back(document_id);
+        } else {
+            RemoveSealedDocument(document_id);
+        }
+    }
+    const int write_segment_count = write_segment_.GetDocumentCount();
+    write_segment_.RemoveDocuments(std::execution::par, write_segment_ids);
+    document_count_ -= write_segment_count - write_segment_.GetDocumentCount();
+}
+
+bool SegmentedSearchServer::RemoveSealedDocument(int document_id) {
+    for (const auto& segment : segments_) {
+        if (segment->HasLiveDocument(document_id)) {
+            segment->AddTombstone(document_id);
+            --document_count_;
+            // a segment that is mostly tombstones may now be due for compaction
+            merge_needed_.notify_one();
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+std::tuple<std::vector<std::string>, DocumentStatus>
+CopyMatchedWords(const std::tuple<std::vector<std::string_view>, DocumentStatus>& match) {
+    const auto& [words, status] = match;
+    return {std::vector<std::string>(words.begin(), words.end()), status};
+}
+
+} // namespace
+
+std::tuple<std::vector<std::string>, DocumentStatus>
+SegmentedSearchServer::MatchDocument(std::string_view raw_query, int document_id) const {
+    std::shared_lock lock(mutex_);
+    // the views point into a segment's terms, so they are copied before unlocking
+    if (write_segment_.HasDocument(document_id)) {
+        return CopyMatchedWords(write_segment_.MatchDocument(raw_query, document_id));
+    }
+    for (const auto& segment : segments_) {
+        if (segment->HasLiveDocument(document_id)) {
+            return CopyMatchedWords(segment->index->MatchDocument(raw_query, document_id));
+        }
+    }
+    throw std::out_of_range("Unknown document_id"s);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const {
+    std::shared_lock lock(mutex_);
+    return document_count_;
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const {
+    std::shared_lock lock(mutex_);
+    return segments_.size() + 1;
+}
+
+void SegmentedSearchServer::Flush() {
+    std::unique_lock lock(mutex_);
+    if (write_segment_.GetDocumentCount() > 0) {
+        SealWriteSegment();
+    }
+}
+
+void SegmentedSearchServer::WaitForMerges() {
+    std::unique_lock lock(mutex_);
+    merge_done_.wait(lock, [this]{
+        return !is_merge_running_ && PickMergeSources().empty();
+    });
+}
+
+void SegmentedSearchServer::SealWriteSegment() {
+    auto segment = std::make_shared<Segment>();
+    segment->index = std::make_shared<const SearchServer>(std::move(write_segment_));
+    segments_.push_back(std::move(segment));
+    write_segment_ = empty_index_;
+    merge_needed_.notify_one();
+}
+
+std::vector<std::shared_ptr<SegmentedSearchServer::Segment>> SegmentedSearchServer::PickMergeSources() const {
+    // size tier t holds segments of write_segment_size_ * MERGE_FACTOR^t documents and up
+    std::map<int, std::vector<std::shared_ptr<Segment>>> tiers;
+    for (const auto& segment : segments_) {
+        if (segment->is_merging) {
+            continue;
+        }
+        const size_t size = segment->index->GetDocumentCount();
+        // mostly dead segments are compacted on their own
+        if (segment->removed_ids.size() * 2 > size) {
+            return {segment};
+        }
+        const double ratio = static_cast<double>(size) / write_segment_size_;
+        const int tier = ratio < 1.0 ? 0 : static_cast<int>(std::log(ratio) / std::log(MERGE_FACTOR));
+        auto& tier_segments = tiers[tier];
+        tier_segments.push_back(segment);
+        if (tier_segments.size() == MERGE_FACTOR) {
+            return tier_segments;
+        }
+    }
+    return {};
+}
+
+void SegmentedSearchServer::RunMerges() {
+    std::unique_lock lock(mutex_);
+    while (true) {
+        std::vector<std::shared_ptr<Segment>> sources;
+        merge_needed_.wait(lock, [&]{
+            if (is_stopping_) {
+                return true;
+            }
+            sources = PickMergeSources();
+            return !sources.empty();
+        });
+        if (is_stopping_) {
+            return;
+        }
+
+        // tombstones are taken per source: an id removed from one source may be
+        // alive again in another
+        std::vector<std::unordered_set<int>> removed_ids;
+        for (const auto& source : sources) {
+            source->is_merging = true;
+            removed_ids.push_back(source->removed_ids);
+        }
+        is_merge_running_ = true;
+
+        // sealed indexes never change, so the merge itself needs no lock
+        lock.unlock();
+        SearchServer merged = empty_index_;
+        for (size_t i = 0; i < sources.size(); ++i) {
+            merged.AddDocumentsFrom(*sources[i]->index, [&source_removed_ids = removed_ids[i]](int document_id){
+                return source_removed_ids.count(document_id) == 0;
+            });
+        }
+        auto segment = std::make_shared<Segment>();
+        segment->index = std::make_shared<const SearchServer>(std::move(merged));
+        lock.lock();
+
+        // documents removed while the merge ran were copied from the source that tombstoned them
+        for (size_t i = 0; i < sources.size(); ++i) {
+            for (int document_id : sources[i]->removed_ids) {
+                if (removed_ids[i].count(document_id) == 0) {
+                    segment->AddTombstone(document_id);
+                }
+            }
+        }
+
+        segments_.erase(std::remove_if(segments_.begin(), segments_.end(), [](const auto& candidate){
+            return candidate->is_merging;
+        }), segments_.end());
+        if (segment->index->GetDocumentCount() > 0) {
+            segments_.push_back(std::move(segment));
+        }
+        is_merge_running_ = false;
+        merge_done_.notify_all();
+    }
+}
+
+double SegmentedSearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
+    size_t document_freq = write_segment_.GetDocumentFreq(word);
+    for (const auto& segment : segments_) {
+        document_freq += segment->index->GetDocumentFreq(word);
+        const auto it = segment->removed_document_freqs.find(word);
+        if (it != segment->removed_document_freqs.end()) {
+            document_freq -= it->second;
+        }
+    }
+    // the word is left only in tombstoned documents, which never match
+    if (document_freq == 0) {
+        return 0.0;
+    }
+    return std::log(document_count_ * 1.0 / document_freq);
+}
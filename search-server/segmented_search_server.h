@@ -0,0 +1,195 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <unordered_map>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <cmath>
+
+#include "search_server.h"
+
+// The index split into segments, LSM style. New documents go to a small write
+// segment, which is sealed once full and never changed again. Removing a sealed
+// document only leaves a tombstone. A background thread merges sealed segments of
+// similar size into bigger ones and drops tombstoned documents on the way, so
+// updates stay cheap and the number of segments stays logarithmic.
+// Queries fan out over the segments with the statistics of the whole index and
+// merge the per-segment tops, so they find what a single SearchServer with the
+// same documents would find.
+// Thread-safe: queries share a lock, changes take it exclusively, and a merge
+// holds it only to swap its result in
+class SegmentedSearchServer {
+public:
+    static const size_t DEFAULT_WRITE_SEGMENT_SIZE = 4096;
+    // this many sealed segments of one size tier are merged into one
+    static const size_t MERGE_FACTOR = 4;
+
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words,
+                                   size_t write_segment_size = DEFAULT_WRITE_SEGMENT_SIZE)
+        : SegmentedSearchServer(SearchServer(stop_words), write_segment_size) {
+    }
+
+    explicit SegmentedSearchServer(std::string_view stop_words_text,
+                                   size_t write_segment_size = DEFAULT_WRITE_SEGMENT_SIZE)
+        : SegmentedSearchServer(SearchServer(stop_words_text), write_segment_size) {
+    }
+
+    explicit SegmentedSearchServer(const std::string& stop_words_text,
+                                   size_t write_segment_size = DEFAULT_WRITE_SEGMENT_SIZE)
+        : SegmentedSearchServer(SearchServer(stop_words_text), write_segment_size) {
+    }
+
+    // Every segment starts as a copy of empty_index, which must have no documents
+    SegmentedSearchServer(SearchServer empty_index, size_t write_segment_size);
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    // Waits for the running merge to finish
+    ~SegmentedSearchServer();
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                     const std::vector<int>& ratings);
+
+    void RemoveDocument(int document_id);
+
+    // Removes from the write segment in bulk and tombstones the rest, under one lock
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    template <typename DocumentPredicate, typename Policy>
+    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query,
+                                           DocumentPredicate document_predicate,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(std::execution::seq, raw_query, document_predicate, max_result_count);
+    }
+
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query, DocumentStatus status,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(policy, raw_query, [status](int, DocumentStatus document_status, int){
+            return document_status == status;
+        }, max_result_count);
+    }
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                           size_t max_result_count = MAX_RESULT_DOCUMENT_COUNT) const {
+        return FindTopDocuments(std::execution::seq, raw_query, status, max_result_count);
+    }
+
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query) const {
+        return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+    }
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const {
+        return FindTopDocuments(std::execution::seq, raw_query);
+    }
+
+    // Like SearchServer::MatchDocument, but the words are copies: a merge may free
+    // the segment they come from as soon as the lock is released.
+    // Throws std::out_of_range for an unknown document
+    std::tuple<std::vector<std::string>, DocumentStatus>
+    MatchDocument(std::string_view raw_query, int document_id) const;
+
+    int GetDocumentCount() const;
+
+    // Sealed segments plus the write segment
+    size_t GetSegmentCount() const;
+
+    // Seals the write segment now, even if it is not full
+    void Flush();
+
+    // Blocks until every merge due so far is done
+    void WaitForMerges();
+
+private:
+    struct Segment {
+        std::shared_ptr<const SearchServer> index;
+        std::unordered_set<int> removed_ids; // tombstones
+        // documents per word among the tombstoned ones, words point into index
+        std::unordered_map<std::string_view, size_t> removed_document_freqs;
+        bool is_merging = false;
+
+        bool HasLiveDocument(int document_id) const {
+            return index->HasDocument(document_id) && removed_ids.count(document_id) == 0;
+        }
+
+        void AddTombstone(int document_id);
+    };
+
+    const SearchServer empty_index_;
+    const size_t write_segment_size_;
+
+    mutable std::shared_mutex mutex_;
+    SearchServer write_segment_;
+    std::vector<std::shared_ptr<Segment>> segments_; // sealed ones
+    int document_count_ = 0;
+
+    std::condition_variable_any merge_needed_;
+    std::condition_variable_any merge_done_;
+    bool is_merge_running_ = false;
+    bool is_stopping_ = false;
+    std::thread merger_;
+
+    void SealWriteSegment();
+
+    // Tombstones a sealed document; false if no sealed segment holds it; requires the lock
+    bool RemoveSealedDocument(int document_id);
+
+    // Segments to merge next, empty if nothing is due; requires the lock
+    std::vector<std::shared_ptr<Segment>> PickMergeSources() const;
+
+    void RunMerges();
+
+    // log(N / n) over the live documents of every segment
+    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+};
+
+template <typename DocumentPredicate, typename Policy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(Policy policy, std::string_view raw_query,
+                                                              DocumentPredicate document_predicate,
+                                                              size_t max_result_count) const {
+    std::shared_lock lock(mutex_);
+
+    // invalid queries throw here, never inside the parallel fan-out
+    write_segment_.NormalizeQuery(raw_query);
+
+    const auto inverse_document_freq = [this](std::string_view word){
+        return ComputeWordInverseDocumentFreq(word);
+    };
+
+    std::vector<const Segment*> segments;
+    segments.reserve(segments_.size());
+    for (const auto& segment : segments_) {
+        segments.push_back(segment.get());
+    }
+    std::vector<std::vector<Document>> segment_tops(segments.size() + 1);
+
+    // every segment keeps its own top; the overall top is among them
+    std::transform(policy, segments.begin(), segments.end(), segment_tops.begin(), [&](const Segment* segment){
+        return segment->index->FindTopDocumentsWithIdf(std::execution::seq, raw_query,
+            [&](int document_id, DocumentStatus status, int rating){
+                return segment->removed_ids.count(document_id) == 0 && document_predicate(document_id, status, rating);
+            }, inverse_document_freq, max_result_count);
+    });
+    segment_tops.back() = write_segment_.FindTopDocumentsWithIdf(std::execution::seq, raw_query,
+        document_predicate, inverse_document_freq, max_result_count);
+
+    TopDocuments top_documents(max_result_count);
+    for (const auto& segment_top : segment_tops) {
+        for (const Document& document : segment_top) {
+            top_documents.Push(document);
+        }
+    }
+    return top_documents.Extract();
+}
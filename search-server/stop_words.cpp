@@ -0,0 +1,61 @@
+#include "stop_words.h"
+
+void StopWordSet::Build(const std::vector<std::string_view>& words) {
+    size_t capacity = 16;
+    while (capacity < words.size() * 2) {
+        capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{});
+    mask_ = capacity - 1;
+
+    for (std::string_view word : words) {
+        if (word.empty() || Contains(word)) {
+            continue;
+        }
+        size_t slot = Hash(word) & mask_;
+        while (slots_[slot].length != 0) {
+            slot = (slot + 1) & mask_;
+        }
+        slots_[slot] = Slot{static_cast<uint32_t>(storage_.size()), static_cast<uint32_t>(word.size())};
+        storage_.append(word);
+        first_chars_.set(static_cast<unsigned char>(word[0]));
+        lengths_ |= LengthBit(word.size());
+        ++size_;
+    }
+}
+
+bool StopWordSet::Contains(std::string_view word) const {
+    if (word.empty() || size_ == 0
+        || (lengths_ & LengthBit(word.size())) == 0
+        || !first_chars_.test(static_cast<unsigned char>(word[0]))) {
+        return false;
+    }
+    for (size_t slot = Hash(word) & mask_; slots_[slot].length != 0; slot = (slot + 1) & mask_) {
+        const Slot& candidate = slots_[slot];
+        if (std::string_view(storage_).substr(candidate.offset, candidate.length) == word) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<std::string_view> StopWordSet::GetWords() const {
+    std::vector<std::string_view> words;
+    words.reserve(size_);
+    for (const Slot& slot : slots_) {
+        if (slot.length != 0) {
+            words.push_back(std::string_view(storage_).substr(slot.offset, slot.length));
+        }
+    }
+    return words;
+}
+
+size_t StopWordSet::Hash(std::string_view word) {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : word) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
\ No newline at end of file
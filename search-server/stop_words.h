@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <bitset>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only set of stop words built once, probed with string_view and no
+// allocation. A first-byte/length prefilter rejects most ordinary words before
+// hashing; the rest go to a flat open-addressing table
+class StopWordSet {
+public:
+    StopWordSet() = default;
+
+    template <typename StringContainer>
+    explicit StopWordSet(const StringContainer& words) {
+        Build(std::vector<std::string_view>(words.begin(), words.end()));
+    }
+
+    bool Contains(std::string_view word) const;
+
+    size_t size() const {
+        return size_;
+    }
+
+    // Every stored word, in no particular order
+    std::vector<std::string_view> GetWords() const;
+
+private:
+    // words live back to back in storage_; offsets keep the set safe to copy
+    struct Slot {
+        uint32_t offset = 0;
+        uint32_t length = 0; // 0 marks a free slot, stop words are never empty
+    };
+
+    std::string storage_;
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    size_t size_ = 0;
+
+    std::bitset<256> first_chars_;
+    uint64_t lengths_ = 0; // bit min(length, 63) is set for every stored length
+
+    void Build(const std::vector<std::string_view>& words);
+
+    static size_t Hash(std::string_view word);
+
+    static uint64_t LengthBit(size_t length) {
+        return uint64_t(1) << (length < 63 ? length : 63);
+    }
+};
\ No newline at end of file
@@ -1,5 +1,12 @@
 #include "string_processing.h"
 
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 std::vector<std::string> SplitIntoWords(const std::string& text) {
     std::vector<std::string> words;
     std::string word;
@@ -23,19 +30,116 @@ std::vector<std::string> SplitIntoWords(const std::string& text) {
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str) {
     std::vector<std::string_view> result;
-    // 1
-    int64_t pos = str.find_first_not_of(" ");
-    // 2
-    const int64_t pos_end = str.npos;
-    // 3
-    while (pos != pos_end) {
-        // 4
-        int64_t space = str.find(' ', pos);
-        // 5
-        result.push_back(space == pos_end ? str.substr(pos) : str.substr(pos, space - pos));
-        // 6
-        pos = str.find_first_not_of(" ", space);
+    SplitIntoWordsView(str, result);
+    return result;
+}
+
+namespace {
+
+const size_t SCAN_BLOCK_SIZE = 64;
+
+// bit i of each mask describes byte i of the block
+struct BlockMasks {
+    uint64_t spaces = 0;
+    uint64_t controls = 0;
+};
+
+BlockMasks ScanBytes(const char* data, size_t size) {
+    BlockMasks masks;
+    for (size_t i = 0; i < size; ++i) {
+        const unsigned char c = static_cast<unsigned char>(data[i]);
+        masks.spaces |= uint64_t(c == ' ') << i;
+        masks.controls |= uint64_t(c < ' ') << i;
     }
+    return masks;
+}
 
-    return result;
+#if defined(__AVX2__)
+
+BlockMasks ScanBlock(const char* data) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i minus_one = _mm256_set1_epi8(-1);
+    BlockMasks masks;
+    for (size_t offset = 0; offset < SCAN_BLOCK_SIZE; offset += 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + offset));
+        // signed compares: 0 <= c < ' ' leaves out the bytes from 0x80 up
+        const __m256i controls = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, minus_one),
+                                                  _mm256_cmpgt_epi8(space, bytes));
+        masks.spaces |= uint64_t(uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, space)))) << offset;
+        masks.controls |= uint64_t(uint32_t(_mm256_movemask_epi8(controls))) << offset;
+    }
+    return masks;
+}
+
+#elif defined(__SSE2__)
+
+BlockMasks ScanBlock(const char* data) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i minus_one = _mm_set1_epi8(-1);
+    BlockMasks masks;
+    for (size_t offset = 0; offset < SCAN_BLOCK_SIZE; offset += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+        // signed compares: 0 <= c < ' ' leaves out the bytes from 0x80 up
+        const __m128i controls = _mm_and_si128(_mm_cmpgt_epi8(bytes, minus_one), _mm_cmplt_epi8(bytes, space));
+        masks.spaces |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, space))) << offset;
+        masks.controls |= uint64_t(_mm_movemask_epi8(controls)) << offset;
+    }
+    return masks;
+}
+
+#else
+
+BlockMasks ScanBlock(const char* data) {
+    return ScanBytes(data, SCAN_BLOCK_SIZE);
+}
+
+#endif
+
+} // namespace
+
+size_t SplitIntoWordsView(std::string_view str, std::vector<std::string_view>& words) {
+    words.clear();
+    const size_t no_position = str.npos;
+    size_t first_control = no_position;
+    size_t invalid_word = no_position;
+    size_t word_begin = no_position;
+
+    const auto add_word = [&](size_t word_end){
+        if (invalid_word == no_position && first_control < word_end) {
+            invalid_word = words.size();
+        }
+        words.push_back(str.substr(word_begin, word_end - word_begin));
+        word_begin = no_position;
+    };
+
+    uint64_t previous_is_word = 0;
+    for (size_t block_begin = 0; block_begin < str.size(); block_begin += SCAN_BLOCK_SIZE) {
+        const size_t block_size = std::min(SCAN_BLOCK_SIZE, str.size() - block_begin);
+        const BlockMasks masks = block_size == SCAN_BLOCK_SIZE ? ScanBlock(str.data() + block_begin)
+                                                               : ScanBytes(str.data() + block_begin, block_size);
+        const uint64_t block_mask = block_size == SCAN_BLOCK_SIZE ? ~uint64_t(0) : (uint64_t(1) << block_size) - 1;
+
+        if (masks.controls != 0 && first_control == no_position) {
+            first_control = block_begin + __builtin_ctzll(masks.controls);
+        }
+
+        // a set bit wherever a word starts or ends
+        const uint64_t is_word = ~masks.spaces & block_mask;
+        uint64_t boundaries = (is_word ^ ((is_word << 1) | previous_is_word)) & block_mask;
+        while (boundaries != 0) {
+            const size_t position = __builtin_ctzll(boundaries);
+            if ((is_word >> position) & 1) {
+                word_begin = block_begin + position;
+            } else {
+                add_word(block_begin + position);
+            }
+            boundaries &= boundaries - 1;
+        }
+        previous_is_word = (is_word >> (block_size - 1)) & 1;
+    }
+    if (word_begin != no_position) {
+        add_word(str.size());
+    }
+
+    return invalid_word == no_position ? words.size() : invalid_word;
 }
\ No newline at end of file
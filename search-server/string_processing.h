@@ -11,6 +11,12 @@ std::vector<std::string> SplitIntoWords(const std::string& text) ;
 
 std::vector<std::string_view> SplitIntoWordsView(std::string_view str) ;
 
+// Replaces the contents of words with the space-separated words of str, reusing its
+// capacity. The same pass looks for control characters (bytes 0x00-0x1F); returns
+// the index of the first word holding one, or words.size() if every word is clean.
+// Scans 64 bytes at a time with AVX2 or SSE2 when the target has them
+size_t SplitIntoWordsView(std::string_view str, std::vector<std::string_view>& words) ;
+
 
 template <typename StringContainer>
 std::set<std::string_view> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
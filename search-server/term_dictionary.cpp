@@ -0,0 +1,106 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <cstring>
+
+TermDictionary::TermDictionary(const TermDictionary& other)
+    : chunks_(other.chunks_)
+    , free_chunks_(other.free_chunks_)
+    , term_to_id_(other.term_to_id_)
+    , terms_(other.terms_)
+    , term_chunks_(other.term_chunks_)
+    , free_ids_(other.free_ids_) {
+    // the free tail of the last chunk stays with other, the copy starts a new chunk
+}
+
+TermDictionary& TermDictionary::operator=(const TermDictionary& other) {
+    if (this != &other) {
+        *this = TermDictionary(other);
+    }
+    return *this;
+}
+
+int TermDictionary::Intern(std::string_view term) {
+    const auto it = term_to_id_.find(term);
+    if (it != term_to_id_.end()) {
+        return it->second;
+    }
+
+    const std::string_view stored = Store(term);
+    return AddStored(stored, current_chunk_);
+}
+
+int TermDictionary::InternBorrowed(std::string_view term) {
+    const auto it = term_to_id_.find(term);
+    if (it != term_to_id_.end()) {
+        return it->second;
+    }
+    return AddStored(term, NO_CHUNK);
+}
+
+int TermDictionary::AddStored(std::string_view stored, size_t chunk) {
+    int term_id;
+    if (free_ids_.empty()) {
+        term_id = static_cast<int>(terms_.size());
+        terms_.push_back(stored);
+        term_chunks_.push_back(chunk);
+    } else {
+        term_id = free_ids_.back();
+        free_ids_.pop_back();
+        terms_[term_id] = stored;
+        term_chunks_[term_id] = chunk;
+    }
+    term_to_id_.emplace(stored, term_id);
+    return term_id;
+}
+
+void TermDictionary::Release(int term_id) {
+    if (term_to_id_.erase(terms_[term_id]) == 0) {
+        return;
+    }
+    terms_[term_id] = {};
+    free_ids_.push_back(term_id);
+
+    const size_t chunk = term_chunks_[term_id];
+    term_chunks_[term_id] = NO_CHUNK;
+    if (chunk != NO_CHUNK) {
+        --chunks_[chunk].live_count;
+        FreeChunkIfUnused(chunk);
+    }
+}
+
+void TermDictionary::FreeChunkIfUnused(size_t chunk) {
+    if (chunk == current_chunk_ || chunks_[chunk].live_count > 0) {
+        return;
+    }
+    // copies sharing the chunk keep it alive for their own terms
+    chunks_[chunk].data.reset();
+    free_chunks_.push_back(chunk);
+}
+
+std::string_view TermDictionary::Store(std::string_view term) {
+    if (term.size() > chunk_free_ || current_chunk_ == NO_CHUNK) {
+        const size_t previous_chunk = current_chunk_;
+        const size_t chunk_size = std::max(ARENA_CHUNK_SIZE, term.size());
+        if (free_chunks_.empty()) {
+            current_chunk_ = chunks_.size();
+            chunks_.emplace_back();
+        } else {
+            current_chunk_ = free_chunks_.back();
+            free_chunks_.pop_back();
+        }
+        chunks_[current_chunk_].data.reset(new char[chunk_size]);
+        chunks_[current_chunk_].live_count = 0;
+        chunk_pos_ = chunks_[current_chunk_].data.get();
+        chunk_free_ = chunk_size;
+        if (previous_chunk != NO_CHUNK) {
+            FreeChunkIfUnused(previous_chunk);
+        }
+    }
+    std::memcpy(chunk_pos_, term.data(), term.size());
+    const std::string_view stored(chunk_pos_, term.size());
+    chunk_pos_ += term.size();
+    chunk_free_ -= term.size();
+    ++chunks_[current_chunk_].live_count;
+    return stored;
+}
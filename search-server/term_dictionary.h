@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// Interned terms: every distinct term is stored once in an append-only arena
+// and gets a small integer id. Ids and views stay valid until the term is
+// released; released ids are handed out again to new terms, and an arena chunk
+// is freed once every term stored in it is released.
+// Copies share the arena chunks, so views taken from one copy stay valid in the
+// others until every copy freed the chunk, and each copy appends to chunks of its own
+class TermDictionary {
+public:
+    static constexpr int NO_TERM = -1;
+
+    TermDictionary() = default;
+
+    TermDictionary(const TermDictionary& other);
+    TermDictionary& operator=(const TermDictionary& other);
+    TermDictionary(TermDictionary&&) = default;
+    TermDictionary& operator=(TermDictionary&&) = default;
+
+    // Id of term, storing it on first sight
+    int Intern(std::string_view term);
+
+    // Like Intern, but refers to the caller's text instead of copying it;
+    // the text must outlive the dictionary
+    int InternBorrowed(std::string_view term);
+
+    // Id of term or NO_TERM
+    int Find(std::string_view term) const {
+        const auto it = term_to_id_.find(term);
+        return it == term_to_id_.end() ? NO_TERM : it->second;
+    }
+
+    std::string_view GetTerm(int term_id) const {
+        return terms_[term_id];
+    }
+
+    // Forgets the term once nothing refers to it any more; its text goes away with
+    // the last live term of its chunk
+    void Release(int term_id);
+
+    void Reserve(size_t term_count) {
+        term_to_id_.reserve(term_count);
+        terms_.reserve(term_count);
+        term_chunks_.reserve(term_count);
+    }
+
+    // Number of live terms
+    size_t size() const {
+        return term_to_id_.size();
+    }
+
+    // Every id handed out so far is below this, for arrays indexed by term id
+    size_t GetIdLimit() const {
+        return terms_.size();
+    }
+
+private:
+    static constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+    // the chunk of a borrowed term, or of none
+    static constexpr size_t NO_CHUNK = static_cast<size_t>(-1);
+
+    struct Chunk {
+        std::shared_ptr<char[]> data; // null once freed, the slot is reused
+        size_t live_count = 0;        // terms stored here and not released
+    };
+
+    std::vector<Chunk> chunks_;
+    std::vector<size_t> free_chunks_;
+    size_t current_chunk_ = NO_CHUNK; // the one Store appends to
+    char* chunk_pos_ = nullptr;
+    size_t chunk_free_ = 0;
+
+    std::unordered_map<std::string_view, int> term_to_id_;
+    std::vector<std::string_view> terms_;
+    std::vector<size_t> term_chunks_; // by term id
+    std::vector<int> free_ids_;
+
+    // Copies term into the arena, the copy never moves; it is counted in current_chunk_
+    std::string_view Store(std::string_view term);
+
+    int AddStored(std::string_view stored, size_t chunk);
+
+    // Frees the chunk if no live term is left in it and Store is done with it
+    void FreeChunkIfUnused(size_t chunk);
+};
\ No newline at end of file
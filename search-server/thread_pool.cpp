@@ -0,0 +1,183 @@
+#include "thread_pool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// the pool and worker the current thread belongs to
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+void PinCurrentThread(size_t cpu) {
+#ifdef __linux__
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#else
+    (void)cpu;
+#endif
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count, bool pin_threads) {
+    thread_count = std::max<size_t>(thread_count, 1);
+    const size_t cpu_count = std::max(1u, std::thread::hardware_concurrency());
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, i, pin_threads, cpu_count]{
+            if (pin_threads) {
+                PinCurrentThread(i % cpu_count);
+            }
+            RunWorker(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard guard(sleep_mutex_);
+        is_stopping_ = true;
+    }
+    task_queued_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::GetCurrentWorker() const {
+    return current_pool == this ? current_worker : GetThreadCount();
+}
+
+void ThreadPool::Push(Task task) {
+    TaskGroup& group = *task.group;
+    size_t worker = GetCurrentWorker();
+    if (worker == GetThreadCount()) {
+        worker = next_worker_++ % GetThreadCount();
+    }
+    // counted before it can be popped, a thief decrements it
+    ++group.queued_count_;
+    {
+        std::lock_guard guard(workers_[worker]->mutex);
+        workers_[worker]->tasks.push_back(std::move(task));
+    }
+    // counted before the sleepers are woken, so none of them can miss the task
+    ++queued_count_;
+    {
+        std::lock_guard guard(sleep_mutex_);
+    }
+    task_queued_.notify_one();
+    // a thread waiting for the group may run the task itself
+    {
+        std::lock_guard guard(group.mutex_);
+    }
+    group.changed_.notify_all();
+}
+
+bool ThreadPool::TryPop(size_t worker, Task& task, const TaskGroup* group) {
+    if (queued_count_ == 0) {
+        return false;
+    }
+    const auto is_wanted = [group](const Task& candidate){
+        return group == nullptr || candidate.group == group;
+    };
+    if (worker < GetThreadCount()) {
+        Worker& own = *workers_[worker];
+        std::lock_guard guard(own.mutex);
+        const auto it = std::find_if(own.tasks.rbegin(), own.tasks.rend(), is_wanted);
+        if (it != own.tasks.rend()) {
+            task = std::move(*it);
+            own.tasks.erase(std::next(it).base());
+            --task.group->queued_count_;
+            --queued_count_;
+            return true;
+        }
+    }
+    for (size_t i = 1; i <= GetThreadCount(); ++i) {
+        Worker& victim = *workers_[(worker + i) % GetThreadCount()];
+        std::lock_guard guard(victim.mutex);
+        const auto it = std::find_if(victim.tasks.begin(), victim.tasks.end(), is_wanted);
+        if (it != victim.tasks.end()) {
+            task = std::move(*it);
+            victim.tasks.erase(it);
+            --task.group->queued_count_;
+            --queued_count_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::Execute(Task& task) {
+    TaskGroup& group = *task.group;
+    std::exception_ptr error;
+    try {
+        task.function();
+    } catch (...) {
+        error = std::current_exception();
+    }
+    task.function = nullptr;
+
+    // the waiter may free the group as soon as the lock is released
+    std::lock_guard guard(group.mutex_);
+    if (error && !group.error_) {
+        group.error_ = error;
+    }
+    if (--group.pending_count_ == 0) {
+        group.changed_.notify_all();
+    }
+}
+
+void ThreadPool::Wait(TaskGroup& group) {
+    const size_t worker = GetCurrentWorker();
+    Task task;
+    while (group.pending_count_ > 0) {
+        // tasks of other groups, e.g. the next queries of a batch, would hold up the
+        // return of this one
+        if (TryPop(worker, task, &group)) {
+            Execute(task);
+            continue;
+        }
+        // the rest is running elsewhere; sleep until one of them queues more
+        // work for the group or the last one finishes
+        std::unique_lock lock(group.mutex_);
+        group.changed_.wait(lock, [&group]{
+            return group.pending_count_ == 0 || group.queued_count_ > 0;
+        });
+    }
+    std::lock_guard guard(group.mutex_);
+    if (group.error_) {
+        std::exception_ptr error = group.error_;
+        group.error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::RunWorker(size_t worker) {
+    current_pool = this;
+    current_worker = worker;
+    Task task;
+    while (true) {
+        if (TryPop(worker, task)) {
+            Execute(task);
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        ++idle_count_;
+        task_queued_.wait(lock, [this]{
+            return is_stopping_ || queued_count_ > 0;
+        });
+        --idle_count_;
+        if (is_stopping_ && queued_count_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include <execution>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+
+// Work-stealing pool. Every worker has its own deque: it runs its newest task
+// first, and an idle worker steals the oldest task of another one, so a big task
+// split into pieces spreads over the pool while small ones stay where they were
+// made. A thread waiting for a TaskGroup runs the queued tasks of that group
+// meanwhile, so tasks may spawn and wait for tasks of their own without blocking
+// the pool, and a waiter never picks up unrelated work that would delay its return
+class ThreadPool {
+public:
+    // Tasks to wait for together
+    class TaskGroup {
+    public:
+        TaskGroup() = default;
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+    private:
+        friend class ThreadPool;
+
+        std::atomic<size_t> pending_count_ = 0;
+        std::atomic<size_t> queued_count_ = 0; // of the pending ones, those not started yet
+        std::mutex mutex_;
+        // a task of the group was queued or finished
+        std::condition_variable changed_;
+        std::exception_ptr error_; // the first one thrown by a task
+    };
+
+    // With pin_threads every worker is bound to one CPU, round robin
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency(), bool pin_threads = false);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs the tasks still queued, then stops the workers
+    ~ThreadPool();
+
+    size_t GetThreadCount() const {
+        return workers_.size();
+    }
+
+    // Workers sleeping for lack of tasks at the moment of the call; a thread
+    // running or waiting for a task is not idle
+    size_t GetIdleThreadCount() const {
+        return idle_count_;
+    }
+
+    // Queues function() as a task of group
+    template <typename Function>
+    void Run(TaskGroup& group, Function function) {
+        ++group.pending_count_;
+        Push({std::function<void()>(std::move(function)), &group});
+    }
+
+    // Returns once every task of group ran, rethrowing the first exception one threw
+    void Wait(TaskGroup& group);
+
+    // function(element) for every element of [first, last), in up to GetThreadCount()
+    // tasks of neighbouring elements; the calling thread takes part
+    template <typename Iterator, typename Function>
+    void ForEach(Iterator first, Iterator last, Function function);
+
+private:
+    struct Task {
+        std::function<void()> function;
+        TaskGroup* group = nullptr;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::atomic<size_t> queued_count_ = 0;
+    std::atomic<size_t> idle_count_ = 0;
+    std::atomic<size_t> next_worker_ = 0; // where tasks from outside the pool go
+    std::mutex sleep_mutex_;
+    std::condition_variable task_queued_;
+    bool is_stopping_ = false;
+
+    void Push(Task task);
+
+    // The newest task of worker, then the oldest one of any other; only tasks of
+    // group unless it is null
+    bool TryPop(size_t worker, Task& task, const TaskGroup* group = nullptr);
+
+    void Execute(Task& task);
+
+    void RunWorker(size_t worker);
+
+    // Index of the worker running the calling thread, or GetThreadCount() outside the pool
+    size_t GetCurrentWorker() const;
+};
+
+template <typename Iterator, typename Function>
+void ThreadPool::ForEach(Iterator first, Iterator last, Function function) {
+    const size_t size = std::distance(first, last);
+    const size_t task_count = std::min(size, GetThreadCount());
+    TaskGroup group;
+    for (size_t task = 0; task < task_count; ++task) {
+        const Iterator task_first = std::next(first, size * task / task_count);
+        const Iterator task_last = std::next(first, size * (task + 1) / task_count);
+        Run(group, [task_first, task_last, &function]{
+            std::for_each(task_first, task_last, function);
+        });
+    }
+    Wait(group);
+}
+
+// Execution policy for SearchServer queries: a heavy query is split into tasks of
+// the pool, a light one runs whole on the calling thread
+class PoolPolicy {
+public:
+    explicit PoolPolicy(ThreadPool& pool)
+        : pool_(&pool) {
+    }
+
+    ThreadPool& GetPool() const {
+        return *pool_;
+    }
+
+private:
+    ThreadPool* pool_;
+};
+
+// std::for_each under a standard execution policy, pool tasks under PoolPolicy
+template <typename Policy, typename Iterator, typename Function>
+void ForEachTask(Policy policy, Iterator first, Iterator last, Function function) {
+    if constexpr (std::is_same_v<std::decay_t<Policy>, PoolPolicy>) {
+        policy.GetPool().ForEach(first, last, function);
+    } else {
+        std::for_each(policy, first, last, function);
+    }
+}
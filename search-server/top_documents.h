@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+
+#include "document.h"
+
+#define SUM_NUMBER 1e-6
+
+// Relevance first, rating breaks ties closer than SUM_NUMBER
+inline bool IsBetterDocument(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < SUM_NUMBER) {
+        return lhs.rating > rhs.rating;
+    } else {
+        return lhs.relevance > rhs.relevance;
+    }
+}
+
+// Keeps the best max_count documents pushed so far. The worst kept document
+// sits at the top of a bounded heap, so each push costs O(log max_count)
+class TopDocuments {
+public:
+    explicit TopDocuments(std::size_t max_count)
+        : max_count_(max_count) {
+        // max_count may well be "no limit", so a big heap grows as documents come
+        heap_.reserve(std::min(max_count, MAX_RESERVED_COUNT));
+    }
+
+    void Push(const Document& document) {
+        if (max_count_ == 0) {
+            return;
+        }
+        if (heap_.size() < max_count_) {
+            heap_.push_back(document);
+            std::push_heap(heap_.begin(), heap_.end(), IsBetterDocument);
+        } else if (IsBetterDocument(document, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), IsBetterDocument);
+            heap_.back() = document;
+            std::push_heap(heap_.begin(), heap_.end(), IsBetterDocument);
+        }
+    }
+
+    // Starts over with a new limit, keeping the memory
+    void Reset(std::size_t max_count) {
+        max_count_ = max_count;
+        heap_.clear();
+    }
+
+    bool IsFull() const {
+        return heap_.size() == max_count_;
+    }
+
+    // Worst document still kept, valid only when not empty
+    const Document& Worst() const {
+        return heap_.front();
+    }
+
+    // Best first; takes no more pushes until Reset
+    const std::vector<Document>& Sort() {
+        std::sort_heap(heap_.begin(), heap_.end(), IsBetterDocument);
+        return heap_;
+    }
+
+    // Best first, leaves the collector empty
+    std::vector<Document> Extract() {
+        Sort();
+        return TakeSorted();
+    }
+
+    // The documents as Sort left them, leaves the collector empty
+    std::vector<Document> TakeSorted() {
+        return std::move(heap_);
+    }
+
+private:
+    static constexpr std::size_t MAX_RESERVED_COUNT = 1024;
+
+    std::size_t max_count_;
+    std::vector<Document> heap_;
+};